@@ -82,7 +82,7 @@ private:
 	std::uniform_real_distribution<float> dis_;
 };
 
-static struct Point
+struct Point
 {
 	Point() = default;
 	Point( float X, float Y )
@@ -107,7 +107,7 @@ static struct Point
 	}
 };
 
-static struct GridPoint
+struct GridPoint
 {
 	GridPoint() = delete;
 	GridPoint( int X, int Y )
@@ -5,11 +5,17 @@ namespace game
 {
 
 BaseNode::BaseNode(std::string name) : mName(name)
+	, mParentNode(nullptr)
+	, mChildIndex(-1)
+	, mDestroyed(false)
+	, mTransformDirty(true)
 {
+	mHandle = NodePool::track(this);
 }
 
 BaseNode::~BaseNode()
 {
+	NodePool::untrack(mHandle);
 }
 
 void BaseNode::update(double deltaTime)
@@ -17,34 +23,43 @@ void BaseNode::update(double deltaTime)
 	for (BaseNode* n : getChildNodes())	n->update(deltaTime);
 }
 
+void BaseNode::markTransformDirty()
+{
+	// Children of a dirty node are always dirty too, so there is nothing left to do below one
+	if (mTransformDirty)
+		return;
+
+	mTransformDirty = true;
+	for (BaseNode* child : mChildNodes)
+		child->markTransformDirty();
+}
+
 void BaseNode::removeChildNode(std::string name)
 {
-	int index = 0;
-	for (BaseNode* n : getChildNodes())
+	for (int i = 0; i < mChildNodes.size(); i++)
 	{
-		if (n->getName() == name)
+		if (mChildNodes.at(i)->getName() == name)
 		{
-			mChildNodes.erase(mChildNodes.begin() + index);
-			n->setParentNode(nullptr);
-			continue;
+			removeChildNode(mChildNodes.at(i));
+			i--;
 		}
-		index++;
 	}
 }
 
 void BaseNode::removeChildNode(BaseNode * node)
 {
-	int index = 0;
-	for (BaseNode* n : getChildNodes())
-	{
-		if (n == node)
-		{
-			mChildNodes.erase(mChildNodes.begin() + index);
-			n->setParentNode(nullptr);
-			continue;
-		}
-		index++;
-	}
+	int index = node->mChildIndex;
+	if (index < 0 || index >= mChildNodes.size() || mChildNodes.at(index) != node)
+		return;
+
+	// Swap with the last child, children are not kept in any particular order
+	BaseNode* last = mChildNodes.back();
+	mChildNodes.at(index) = last;
+	last->mChildIndex = index;
+	mChildNodes.pop_back();
+
+	node->mChildIndex = -1;
+	node->setParentNode(nullptr);
 }
 
 BaseNode* BaseNode::getRootNode()
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <vector>
 
+#include "node_pool.h"
 
 
 namespace game
@@ -19,30 +20,52 @@ namespace game
 		BaseNode* mParentNode;
 		std::vector<BaseNode*> mChildNodes;
 		std::vector<std::string> tags;
+		NodeHandle mHandle;
+		int mChildIndex;		// Position in the parent's child list, so removing a child doesn't search for it
+		bool mDestroyed;		// Queued for destruction at the end of the tick
+		bool mTransformDirty;	// Cached transforms of this node and everything below it need rebuilding
 
+		friend class SceneGraph;
 
 	public:
 		BaseNode(std::string name);
-		~BaseNode();
+		virtual ~BaseNode();
+
+		// Nodes live in the NodePool. The destructor is virtual, so delete frees the slot of the right size
+		static void* operator new(size_t size) { return NodePool::allocate(size); }
+		static void operator delete(void* memory, size_t size) { NodePool::free(memory, size); }
 
 		virtual void update(double deltaTime);
 
 		// Getters
 		const std::string getName() const { return mName; }
+		// Weak reference that outlives the node, see NodePool::resolve
+		inline NodeHandle getHandle() const { return mHandle; }
 		inline BaseNode* getParentNode() { return mParentNode; }
 		inline std::vector<BaseNode*> getChildNodes() { return mChildNodes; }
+		// Still in the scene until the end of the tick, but nothing should interact with it anymore
+		inline bool isDestroyed() const { return mDestroyed; }
 
 		// Setters
 		inline void setName(std::string new_name) { mName = new_name; }
 		inline void setParentNode(BaseNode* n) { mParentNode = n; }
 
 		// Children
-		template<class T> void addChildNode(T* n) { mChildNodes.push_back(n);}
+		template<class T> void addChildNode(T* n)
+		{
+			BaseNode* child = n;
+			child->mChildIndex = (int)mChildNodes.size();
+			mChildNodes.push_back(child);
+			child->markTransformDirty();
+		}
 		void removeChildNode(std::string name);
 		void removeChildNode(BaseNode* node);
 
 		BaseNode* getRootNode();
 
+		// The node moved, or something it hangs from did: rebuild its transforms and its children's before drawing
+		void markTransformDirty();
+
 		// Tags
 		void addTag(std::string tag);
 		void removeTag(std::string tag);
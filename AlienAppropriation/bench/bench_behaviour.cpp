@@ -0,0 +1,87 @@
+// Behaviour update throughput with the C library rand() against each entity's own Random
+// The step is CowEntityNode::doWalk: two random direction components, then the velocity is steered and
+// renormalised. "rand()" is the draw the behaviour code used before, behind glibc's lock;
+// "Random" the per-entity xoshiro128+ it uses now. Both run through the JobSystem like the think phase.
+
+#include <cstdlib>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "job_system.h"
+#include "random.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+// Ticks per timed run, and entities per job like SceneGraph::update
+const int ticks_g = 20;
+const int reps_g = 5;
+const int grain_g = 256;
+
+// struct Walker
+// The state doWalk touches
+struct Walker {
+	glm::vec3 velocity;
+	Random random;
+};
+
+// What the behaviour code did before: rand() scaled into [-1, 1]
+static inline float OldUniform()
+{
+	return -1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f)));
+}
+
+static inline void Steer(Walker& w, glm::vec3 dirVec)
+{
+	glm::vec3 velocity = w.velocity + 0.02f * glm::normalize(dirVec);
+	w.velocity = 0.2f * glm::normalize(velocity);
+}
+
+static double Run(JobSystem& jobs, std::vector<Walker>& walkers, bool useRand)
+{
+	int count = (int)walkers.size();
+	return bench::TimeBest(reps_g, [&]() {
+		for (Walker& w : walkers)
+			w.velocity = glm::vec3(0.0f, 0.0f, 0.2f);
+	}, [&]() {
+		for (int t = 0; t < ticks_g; t++) {
+			jobs.parallelFor(count, grain_g, [&](int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					Walker& w = walkers[i];
+					if (useRand)
+						Steer(w, glm::vec3(OldUniform(), 0.0f, OldUniform()));
+					else
+						Steer(w, glm::vec3(w.random.uniform(-1.0f, 1.0f), 0.0f, w.random.uniform(-1.0f, 1.0f)));
+				}
+			});
+		}
+	});
+}
+
+int main()
+{
+	Random::setGlobalSeed(1234);
+	srand(1234);
+
+	// One thread, then every hardware thread like the game
+	JobSystem jobs;
+	std::vector<int> threadCounts = { 1 };
+	if (jobs.getThreadCount() > 1)
+		threadCounts.push_back(jobs.getThreadCount());
+
+	for (int threads : threadCounts) {
+		jobs.setThreadCount(threads);
+
+		printf("%d thread(s)\n", threads);
+		bench::PrintHeader("Behaviour step, 20 ticks", "rand()", "Random");
+		for (int count : { 1000, 10000, 100000 }) {
+			std::vector<Walker> walkers(count);
+			double before = Run(jobs, walkers, true);
+			double after = Run(jobs, walkers, false);
+			bench::PrintRow(count, before, after);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
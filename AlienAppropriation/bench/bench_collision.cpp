@@ -0,0 +1,109 @@
+// Narrowphase: the batched Narrowphase against calling Overlap pair by pair
+// Before timing, checks that both agree on every pair and exits with 1 if they don't.
+// Shapes are a random mix of points, capsules and boxes, close enough together that some of the pairs overlap.
+// The batched time includes queueing the pairs, which SceneGraph::update pays every tick as well.
+
+#include <algorithm>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "collision.h"
+#include "random.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+const int reps_g = 10;
+
+// Pairs checked for agreement, separate from the timed sets so every pair kind shows up plenty of times
+const int check_pairs_g = 100000;
+
+struct ShapePair {
+	CollisionShape a, b;
+};
+
+static CollisionShape RandomShape(Random& random)
+{
+	CollisionShape s;
+	s.type = (CollisionType)random.range(3);
+	s.center = glm::vec3(random.uniform(-3.0f, 3.0f), random.uniform(-3.0f, 3.0f), random.uniform(-3.0f, 3.0f));
+	s.radius = random.uniform(0.2f, 1.5f);
+	s.extents = glm::vec3(random.uniform(0.1f, 2.0f), random.uniform(0.0f, 2.0f), random.uniform(0.1f, 2.0f));
+
+	glm::quat q = glm::normalize(glm::quat(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f)));
+	glm::mat3 rotation = glm::mat3_cast(q);
+	for (int i = 0; i < 3; i++)
+		s.axes[i] = rotation[i];
+
+	// Points only use the center and radius, but give them the identity like SceneNode does
+	if (s.type == Point) {
+		s.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+		s.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+		s.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+		s.extents = glm::vec3(0.0f);
+	}
+	return s;
+}
+
+static std::vector<ShapePair> RandomPairs(int count, uint32_t seed)
+{
+	Random random(seed);
+	std::vector<ShapePair> pairs(count);
+	for (ShapePair& pair : pairs) {
+		pair.a = RandomShape(random);
+		pair.b = RandomShape(random);
+	}
+	return pairs;
+}
+
+// Ids of the overlapping pairs, pair by pair
+static void RunOverlap(const std::vector<ShapePair>& pairs, std::vector<int>& hits)
+{
+	for (int i = 0; i < (int)pairs.size(); i++) {
+		if (Overlap(pairs[i].a, pairs[i].b))
+			hits.push_back(i);
+	}
+}
+
+// The same through the Narrowphase, queued and run the way SceneGraph::update does every tick
+static void RunBatched(Narrowphase& narrowphase, const std::vector<ShapePair>& pairs, std::vector<int>& hits)
+{
+	narrowphase.clear();
+	for (int i = 0; i < (int)pairs.size(); i++)
+		narrowphase.add(pairs[i].a, pairs[i].b, i);
+	narrowphase.run(hits);
+}
+
+int main()
+{
+	// Agreement: the SSE2 batches must give exactly what Overlap gives
+	{
+		std::vector<ShapePair> pairs = RandomPairs(check_pairs_g, 99);
+		Narrowphase narrowphase;
+		std::vector<int> expected, batched;
+		RunOverlap(pairs, expected);
+		RunBatched(narrowphase, pairs, batched);
+		std::sort(batched.begin(), batched.end());
+
+		if (expected != batched) {
+			printf("Narrowphase disagrees with Overlap: %zu overlaps against %zu\n", batched.size(), expected.size());
+			return 1;
+		}
+		printf("Narrowphase agrees with Overlap on %d pairs, %zu overlapping\n\n", check_pairs_g, expected.size());
+	}
+
+	bench::PrintHeader("Narrowphase pairs per tick", "Overlap", "batched");
+	for (int count : { 1000, 5000, 20000 }) {
+		std::vector<ShapePair> pairs = RandomPairs(count, 1234);
+		Narrowphase narrowphase;
+		std::vector<int> hits;
+		hits.reserve(count);
+
+		double before = bench::TimeBest(reps_g, [&]() { hits.clear(); }, [&]() { RunOverlap(pairs, hits); });
+		double after = bench::TimeBest(reps_g, [&]() { hits.clear(); }, [&]() { RunBatched(narrowphase, pairs, hits); });
+		bench::PrintRow(count, before, after);
+	}
+
+	return 0;
+}
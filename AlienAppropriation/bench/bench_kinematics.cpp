@@ -0,0 +1,117 @@
+// Batched entity kinematics against the one-entity-at-a-time reference
+// IntegrateKinematicsScalar is the per-node integration EntityNode::update used to do,
+// IntegrateKinematics the SSE2 (or AVX2 with ENABLE_AVX2) path SceneGraph::update runs now.
+// Before timing, checks that both give the same entities and landings and exits with 1 if they don't.
+
+#include <random>
+#include <vector>
+
+#include "kinematics.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+// Ticks integrated per timed run
+const int ticks_g = 20;
+const int reps_g = 10;
+
+// Entities checked for agreement, an odd count so the scalar tail after the last full batch runs too
+const int check_entities_g = 10003;
+
+// struct Entities
+// Storage for a KinematicsBatch, half of it airborne above the map and half on the ground
+struct Entities {
+	std::vector<float> posX, posY, posZ, velX, velY, velZ;
+	std::vector<int> grounded;
+
+	void reset(int count)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		posX.resize(count); posY.resize(count); posZ.resize(count);
+		velX.resize(count); velY.resize(count); velZ.resize(count);
+		grounded.resize(count);
+		for (int i = 0; i < count; i++) {
+			posX[i] = 300.0f * unit(random);
+			posY[i] = 20.0f * unit(random);
+			posZ[i] = 300.0f * unit(random);
+			velX[i] = unit(random) - 0.5f;
+			velY[i] = 0.4f * unit(random) - 0.2f;
+			velZ[i] = unit(random) - 0.5f;
+			grounded[i] = unit(random) < 0.5f;
+		}
+	}
+
+	KinematicsBatch batch()
+	{
+		KinematicsBatch b;
+		b.posX = posX.data(); b.posY = posY.data(); b.posZ = posZ.data();
+		b.velX = velX.data(); b.velY = velY.data(); b.velZ = velZ.data();
+		b.grounded = grounded.data();
+		b.count = (int)posX.size();
+		b.gravity = -0.05f;
+		b.minBound = 0.0f;
+		b.maxBound = 300.0f;
+		return b;
+	}
+
+	// Same lanes do the same operations in the same order, so the two paths must match exactly
+	bool operator==(const Entities& other) const
+	{
+		return posX == other.posX && posY == other.posY && posZ == other.posZ &&
+			velX == other.velX && velY == other.velY && velZ == other.velZ && grounded == other.grounded;
+	}
+};
+
+int main()
+{
+	// Agreement: every tick, the same state and the same entities landing in the same order
+	{
+		Entities scalar, batched;
+		scalar.reset(check_entities_g);
+		batched.reset(check_entities_g);
+		KinematicsBatch b1 = scalar.batch(), b2 = batched.batch();
+		std::vector<int> landed1, landed2;
+
+		for (int t = 0; t < ticks_g; t++) {
+			landed1.clear();
+			landed2.clear();
+			IntegrateKinematicsScalar(b1, 0, b1.count, landed1);
+			IntegrateKinematics(b2, landed2);
+
+			if (!(scalar == batched) || landed1 != landed2) {
+				printf("IntegrateKinematics disagrees with IntegrateKinematicsScalar on tick %d\n", t);
+				return 1;
+			}
+		}
+		printf("IntegrateKinematics agrees with IntegrateKinematicsScalar on %d entities over %d ticks\n\n", check_entities_g, ticks_g);
+	}
+
+	bench::PrintHeader("Entity kinematics, 20 ticks", "per entity", "batched");
+
+	for (int count : { 1000, 10000, 100000 }) {
+		Entities entities;
+		std::vector<int> landed;
+		landed.reserve(count);
+
+		double scalar = bench::TimeBest(reps_g, [&]() { entities.reset(count); }, [&]() {
+			KinematicsBatch b = entities.batch();
+			for (int t = 0; t < ticks_g; t++) {
+				landed.clear();
+				IntegrateKinematicsScalar(b, 0, b.count, landed);
+			}
+		});
+
+		double batched = bench::TimeBest(reps_g, [&]() { entities.reset(count); }, [&]() {
+			KinematicsBatch b = entities.batch();
+			for (int t = 0; t < ticks_g; t++) {
+				landed.clear();
+				IntegrateKinematics(b, landed);
+			}
+		});
+
+		bench::PrintRow(count, scalar, batched);
+	}
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+// Particle rendering: quads expanded in a geometry shader against point sprites sized in the vertex shader
+// Draws the tractor beam's particles with particleBeamMaterial and particleBeamSpriteMaterial at 3k, 30k and
+// 300k points into a hidden window, and times whole frames up to glFinish.
+// Needs a GL 4.0 context; run it on the driver you care about, software rasterizers included
+
+#include <cstdio>
+#include <string>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bin/path_config.h"
+#include "resource_manager.h"
+#include "uniform_buffers.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+const int width_g = 800;
+const int height_g = 600;
+const float fov_g = 20.0f;
+
+// Frames per timed run
+const int frames_g = 20;
+const int reps_g = 3;
+
+// Particle layout of CreateParticles_Point: position(3), normal(3), color(3), uv(2)
+const int particle_floats_g = 11;
+
+static void DrawPoints(GLuint program, const Resource* points, float time)
+{
+	// The beam shaders animate on the frame time, give them a different frame every time
+	FrameUniforms frame = FrameUniforms();
+	frame.view = glm::lookAt(glm::vec3(0.0f, -20.0f, 120.0f), glm::vec3(0.0f, -20.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	frame.projection = glm::perspective(glm::radians(fov_g), (float)width_g / height_g, 0.01f, 1000.0f);
+	frame.cameraPosition = glm::vec4(0.0f, -20.0f, 120.0f, 1.0f);
+	frame.time = time;
+	frame.pixelsPerUnit = height_g / (2.0f * tan(glm::radians(fov_g) / 2.0f));
+	UniformBuffers::SetFrame(frame);
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glUseProgram(program);
+	glBindBuffer(GL_ARRAY_BUFFER, points->getArrayBuffer());
+
+	const char* names[] = { "vertex", "normal", "color" };
+	GLint attributes[3];
+	for (int i = 0; i < 3; i++) {
+		attributes[i] = glGetAttribLocation(program, names[i]);
+		if (attributes[i] >= 0) {
+			glVertexAttribPointer(attributes[i], 3, GL_FLOAT, GL_FALSE, particle_floats_g * sizeof(GLfloat), (void *)(i * 3 * sizeof(GLfloat)));
+			glEnableVertexAttribArray(attributes[i]);
+		}
+	}
+
+	UniformBuffers::SetObject(glm::mat4(1.0f), glm::mat4(1.0f));
+	glDrawArrays(GL_POINTS, 0, points->getSize());
+
+	for (int i = 0; i < 3; i++) {
+		if (attributes[i] >= 0)
+			glDisableVertexAttribArray(attributes[i]);
+	}
+}
+
+static double TimeFrames(GLuint program, const Resource* points)
+{
+	return bench::TimeBest(reps_g, []() { glFinish(); }, [&]() {
+		for (int f = 0; f < frames_g; f++) {
+			DrawPoints(program, points, f * 0.05f);
+		}
+		glFinish();
+	});
+}
+
+int main()
+{
+	if (!glfwInit()) {
+		fprintf(stderr, "Could not initialize the GLFW library\n");
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(width_g, height_g, "bench_particles", NULL, NULL);
+	if (!window) {
+		fprintf(stderr, "Could not create window\n");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK) {
+		fprintf(stderr, "Could not initialize the GLEW library\n");
+		glfwTerminate();
+		return 1;
+	}
+
+	glViewport(0, 0, width_g, height_g);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	UniformBuffers::Init();
+
+	try {
+		ResourceManager resources;
+		std::string shaders = SHADER_DIRECTORY;
+		resources.LoadResource(Material, "particleBeamMaterial", (shaders + "/particleBeam").c_str());
+		resources.LoadResource(Material, "particleBeamSpriteMaterial", (shaders + "/particleBeamSprite").c_str());
+		GLuint geometry = ResourceManager::getResource("particleBeamMaterial")->getResource();
+		GLuint sprites = ResourceManager::getResource("particleBeamSpriteMaterial")->getResource();
+
+		printf("%s\n", (const char*)glGetString(GL_RENDERER));
+		bench::PrintHeader("Beam particles, 20 frames", "geometry", "sprites");
+		for (int count : { 3000, 30000, 300000 }) {
+			std::string name = "points" + std::to_string(count);
+			resources.CreateParticles_Point(name, count);
+			const Resource* points = ResourceManager::getResource(name);
+
+			double before = TimeFrames(geometry, points);
+			double after = TimeFrames(sprites, points);
+			bench::PrintRow(count, before, after);
+		}
+	}
+	catch (std::exception& e) {
+		fprintf(stderr, "%s\n", e.what());
+		UniformBuffers::Destroy();
+		glfwTerminate();
+		return 1;
+	}
+
+	UniformBuffers::Destroy();
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,40 @@
+// Poisson disk sampling: the original PoissonGenerator against GeneratePoissonPoints
+// Same arguments for both, over the whole unit square like the map-wide call in MapGenerator
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "PoissonGenerator.h"
+#include "poisson_sampler.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+// Candidates tried around each point
+const int new_points_g = 30;
+
+int main()
+{
+	bench::PrintHeader("Poisson disk points", "PoissonGen", "flat grid");
+
+	for (int count : { 10000, 100000, 1000000 }) {
+		// The old sampler takes seconds at a million points, one run is enough there
+		int reps = count >= 1000000 ? 1 : 3;
+		size_t oldPoints = 0, newPoints = 0;
+
+		double before = bench::TimeBest(reps, []() {}, [&]() {
+			PoissonGenerator::DefaultPRNG prng(1234);
+			oldPoints = PoissonGenerator::generatePoissonPoints(count, prng, new_points_g, false).size();
+		});
+
+		double after = bench::TimeBest(reps, []() {}, [&]() {
+			Random random(1234);
+			newPoints = GeneratePoissonPoints(count, random, new_points_g, false).size();
+		});
+
+		bench::PrintRow(count, before, after);
+		printf("%10s %12zu pts %10zu pts\n", "", oldPoints, newPoints);
+	}
+
+	return 0;
+}
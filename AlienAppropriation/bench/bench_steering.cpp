@@ -0,0 +1,120 @@
+// Projectile steering: the batched SteerProjectiles against the one-projectile-at-a-time reference
+// SteerProjectilesScalar is what every ProjectileNode did for itself, SteerProjectiles what
+// ProjectileStore::update runs now, SSE2 or AVX2 with ENABLE_AVX2.
+// Before timing, checks that both give the same velocities and facings and exits with 1 if they don't.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "kinematics.h"
+#include "random.h"
+#include "bench_timer.h"
+
+using namespace game;
+
+// Ticks steered per timed run
+const int ticks_g = 20;
+const int reps_g = 10;
+
+// Same as homing_turn_g in the ProjectileStore
+const float turn_g = 0.2f;
+
+// Largest difference allowed between the two paths, on velocity and quaternion components
+// The lanes do the same math in a different order, so the results are close but not bit exact
+const float tolerance_g = 1e-3f;
+
+// struct Swarm
+// Storage for a SteeringBatch, projectiles around the player with two out of three homing
+struct Swarm {
+	std::vector<float> posX, posY, posZ, velX, velY, velZ, maxSpeed;
+	std::vector<float> orientW, orientX, orientY, orientZ;
+
+	void reset(int count)
+	{
+		Random random(1234);
+		posX.resize(count); posY.resize(count); posZ.resize(count);
+		velX.resize(count); velY.resize(count); velZ.resize(count);
+		maxSpeed.resize(count);
+		orientW.assign(count, 1.0f); orientX.assign(count, 0.0f); orientY.assign(count, 0.0f); orientZ.assign(count, 0.0f);
+		for (int i = 0; i < count; i++) {
+			posX[i] = random.uniform(-50.0f, 50.0f);
+			posY[i] = random.uniform(0.0f, 30.0f);
+			posZ[i] = random.uniform(-50.0f, 50.0f);
+			velX[i] = random.uniform(-1.0f, 1.0f);
+			velY[i] = random.uniform(-1.0f, 1.0f);
+			velZ[i] = random.uniform(-1.0f, 1.0f);
+			maxSpeed[i] = i % 3 ? 1.0f : 0.0f;
+		}
+	}
+
+	SteeringBatch batch()
+	{
+		SteeringBatch b;
+		b.posX = posX.data(); b.posY = posY.data(); b.posZ = posZ.data();
+		b.velX = velX.data(); b.velY = velY.data(); b.velZ = velZ.data();
+		b.maxSpeed = maxSpeed.data();
+		b.orientW = orientW.data(); b.orientX = orientX.data(); b.orientY = orientY.data(); b.orientZ = orientZ.data();
+		b.count = (int)posX.size();
+		b.targetX = 3.0f; b.targetY = 4.0f; b.targetZ = 5.0f;
+		b.turn = turn_g;
+		return b;
+	}
+};
+
+// Largest component difference between two swarms
+static float MaxDifference(const Swarm& a, const Swarm& b)
+{
+	const std::vector<float> Swarm::* fields[] = { &Swarm::velX, &Swarm::velY, &Swarm::velZ,
+		&Swarm::orientW, &Swarm::orientX, &Swarm::orientY, &Swarm::orientZ };
+
+	float difference = 0.0f;
+	for (auto field : fields) {
+		for (size_t i = 0; i < (a.*field).size(); i++)
+			difference = std::max(difference, std::fabs((a.*field)[i] - (b.*field)[i]));
+	}
+	return difference;
+}
+
+int main()
+{
+	// Agreement: an odd count so the scalar tail after the last full batch gets checked too
+	{
+		const int count = 10003;
+		Swarm scalar, batched;
+		scalar.reset(count);
+		batched.reset(count);
+		SteeringBatch b1 = scalar.batch(), b2 = batched.batch();
+		SteerProjectilesScalar(b1, 0, count);
+		SteerProjectiles(b2);
+
+		float difference = MaxDifference(scalar, batched);
+		if (!(difference <= tolerance_g)) {
+			printf("SteerProjectiles disagrees with SteerProjectilesScalar by %g\n", difference);
+			return 1;
+		}
+		printf("SteerProjectiles agrees with SteerProjectilesScalar on %d projectiles, within %g\n\n", count, difference);
+	}
+
+	bench::PrintHeader("Projectile steering, 20 ticks", "per projectile", "batched");
+
+	for (int count : { 1000, 5000, 10000, 50000 }) {
+		Swarm swarm;
+
+		double scalar = bench::TimeBest(reps_g, [&]() { swarm.reset(count); }, [&]() {
+			SteeringBatch b = swarm.batch();
+			for (int t = 0; t < ticks_g; t++)
+				SteerProjectilesScalar(b, 0, b.count);
+		});
+
+		double batched = bench::TimeBest(reps_g, [&]() { swarm.reset(count); }, [&]() {
+			SteeringBatch b = swarm.batch();
+			for (int t = 0; t < ticks_g; t++)
+				SteerProjectiles(b);
+		});
+
+		bench::PrintRow(count, scalar, batched);
+	}
+
+	return 0;
+}
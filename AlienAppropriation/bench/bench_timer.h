@@ -0,0 +1,42 @@
+#ifndef BENCH_TIMER_H_
+#define BENCH_TIMER_H_
+
+#include <chrono>
+#include <cstdio>
+
+// Shared by the benchmark executables in bench/
+// Numbers only mean something in an optimised build (CMAKE_BUILD_TYPE=Release)
+
+namespace bench {
+
+	// Run 'setup' then time 'body', 'reps' times, and return the best run in microseconds
+	// The best run is the one least disturbed by the rest of the machine
+	template<typename Setup, typename Body>
+	double TimeBest(int reps, Setup setup, Body body)
+	{
+		double best = 1e30;
+		for (int r = 0; r < reps; r++) {
+			setup();
+			auto start = std::chrono::steady_clock::now();
+			body();
+			auto end = std::chrono::steady_clock::now();
+			double us = std::chrono::duration<double, std::micro>(end - start).count();
+			if (us < best)
+				best = us;
+		}
+		return best;
+	}
+
+	inline void PrintHeader(const char* what, const char* before, const char* after)
+	{
+		printf("%s\n%10s %14s %14s %9s\n", what, "count", before, after, "speedup");
+	}
+
+	inline void PrintRow(int count, double before, double after)
+	{
+		printf("%10d %12.1fus %12.1fus %8.2fx\n", count, before, after, after > 0.0 ? before / after : 0.0);
+	}
+
+} // namespace bench
+
+#endif // BENCH_TIMER_H_
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cmath>
+
+#include "broadphase.h"
+
+namespace game {
+
+Broadphase::Broadphase(int cells, float cellSize)
+	: mCells(cells)
+	, mCellSize(cellSize)
+{
+}
+
+
+int Broadphase::add(SceneNode* node, glm::vec3 center, float radius, int layers, int mask)
+{
+	mProxies.push_back({ node, glm::vec2(center.x, center.z), radius, layers, mask });
+	return (int)mProxies.size() - 1;
+}
+
+void Broadphase::clear()
+{
+	mProxies.clear();
+	mAskers.clear();
+	mPairs.clear();
+}
+
+void Broadphase::coveredCells(const Proxy& proxy, std::vector<uint32_t>& cells) const
+{
+	cells.clear();
+
+	// Never more than the whole grid, however big the proxy
+	int minX = (int)std::floor((proxy.center.x - proxy.radius) / mCellSize);
+	int maxX = std::min((int)std::floor((proxy.center.x + proxy.radius) / mCellSize), minX + mCells - 1);
+	int minY = (int)std::floor((proxy.center.y - proxy.radius) / mCellSize);
+	int maxY = std::min((int)std::floor((proxy.center.y + proxy.radius) / mCellSize), minY + mCells - 1);
+
+	for (int x = minX; x <= maxX; x++) {
+		int wx = x % mCells;
+		if (wx < 0) wx += mCells;
+		for (int y = minY; y <= maxY; y++) {
+			int wy = y % mCells;
+			if (wy < 0) wy += mCells;
+			cells.push_back((uint32_t)(wx * mCells + wy));
+		}
+	}
+}
+
+void Broadphase::build()
+{
+	mAskers.clear();
+	mPairs.clear();
+
+	std::vector<uint32_t> cells;
+	for (int i = 0; i < (int)mProxies.size(); i++) {
+		if (mProxies[i].mask == 0)
+			continue;
+		coveredCells(mProxies[i], cells);
+		for (uint32_t cell : cells) {
+			mAskers.push_back({ cell, i });
+		}
+	}
+	if (mAskers.empty())
+		return;
+	std::sort(mAskers.begin(), mAskers.end());
+
+	// Every proxy looks for askers wanting it in the cells it covers
+	for (int i = 0; i < (int)mProxies.size(); i++) {
+		const Proxy& proxy = mProxies[i];
+		coveredCells(proxy, cells);
+		for (uint32_t cell : cells) {
+			auto range = std::equal_range(mAskers.begin(), mAskers.end(), CellEntry{ cell, 0 });
+			for (auto asker = range.first; asker != range.second; asker++) {
+				int a = asker->proxy;
+				if (a == i || !(mProxies[a].mask & proxy.layers))
+					continue;
+				// Two proxies asking for each other make one pair, from the first one's side
+				if ((proxy.mask & mProxies[a].layers) && i < a)
+					continue;
+				mPairs.push_back({ a, i });
+			}
+		}
+	}
+
+	// Proxies sharing more than one cell met in each of them
+	std::sort(mPairs.begin(), mPairs.end());
+	mPairs.erase(std::unique(mPairs.begin(), mPairs.end()), mPairs.end());
+}
+
+} // namespace game
@@ -0,0 +1,78 @@
+#ifndef BROADPHASE_H_
+#define BROADPHASE_H_
+
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+namespace game {
+
+	class SceneNode;
+
+	// What a proxy is, as bits: a proxy can be several things at once and asks for pairs by the same bits
+	enum BroadphaseLayer { PlayerLayer = 1, BombLayer = 2, BombableLayer = 4, SolidLayer = 8 };
+
+	// struct BroadphasePair
+	// Two proxies whose cells overlap, 'a' is the one that asked for the other
+	struct BroadphasePair {
+		int a, b;
+
+		inline bool operator<(const BroadphasePair& other) const { return a < other.a || (a == other.a && b < other.b); }
+		inline bool operator==(const BroadphasePair& other) const { return a == other.a && b == other.b; }
+	};
+
+	// class Broadphase
+	// Candidate pairs for every collision test of a tick, gathered once.
+	// Proxies are circles in x/z filed under every cell of a wrapping grid they overlap, so an object
+	// straddling a cell border meets everything on both sides. Only the few proxies that ask for something
+	// (the player, falling bombs) are actually stored per cell. Everything else only looks up the cells it
+	// covers, so a world full of trees costs one lookup per tree and never a pair between two trees.
+	// Pairs are the same wherever the proxies were added from and come out sorted with no duplicates.
+	class Broadphase {
+
+	public:
+		Broadphase(int cells, float cellSize);
+
+		// Add a proxy for this tick: a circle around 'center' (in x/z), what it is and what it wants to meet
+		// Returns its index
+		int add(SceneNode* node, glm::vec3 center, float radius, int layers, int mask);
+		// Pair up the proxies
+		void build();
+		void clear();
+
+		inline const std::vector<BroadphasePair>& getPairs() const { return mPairs; }
+		inline SceneNode* getNode(int proxy) const { return mProxies[proxy].node; }
+		inline int getLayers(int proxy) const { return mProxies[proxy].layers; }
+		inline int getCount() const { return (int)mProxies.size(); }
+
+	private:
+		struct Proxy {
+			SceneNode* node;
+			glm::vec2 center;
+			float radius;
+			int layers;
+			int mask;
+		};
+
+		// A cell covered by a proxy that asks for something, sorted by cell
+		struct CellEntry {
+			uint32_t cell;
+			int proxy;
+
+			inline bool operator<(const CellEntry& other) const { return cell < other.cell; }
+		};
+
+		int mCells;
+		float mCellSize;
+		std::vector<Proxy> mProxies;
+		std::vector<CellEntry> mAskers;
+		std::vector<BroadphasePair> mPairs;
+
+		// Cells a proxy covers, wrapped into the grid
+		void coveredCells(const Proxy& proxy, std::vector<uint32_t>& cells) const;
+
+	}; // class Broadphase
+
+} // namespace game
+
+#endif // BROADPHASE_H_
@@ -14,6 +14,8 @@ namespace game {
 Camera::Camera(std::string name)
 	: SceneNode(name)
 	, mCameraPerspective(Third)
+	, mPixelsPerUnit(1.0f)
+	, mFrameTime(0.0)
 {
 }
 
@@ -52,6 +54,8 @@ void Camera::draw(SceneNode *camera, glm::mat4 parentTransf)
 	
 	for (BaseNode* bn : getChildNodes())
 	{
+		// The camera moves every frame and doesn't cache its own transform, so neither can anything it carries
+		bn->markTransformDirty();
 		if (mCameraPerspective == Third) {
 			dynamic_cast<SceneNode*>(bn)->draw(camera, parentTransf);
 		}
@@ -69,9 +73,8 @@ void Camera::update(double deltaTime)
 	mPosition += -mVelocity.z * playerForward;
 	mVelocity.z *= 0.95;
 
-	mPosition.x = glm::clamp(mPosition.x, 0.0f, 300.0f);
+	// The world is streamed around the camera, so only the height is limited
 	mPosition.y = glm::clamp(mPosition.y, 5.0f, 50.0f);
-	mPosition.z = glm::clamp(mPosition.z, 40.0f, 340.0f);
 
 	for (BaseNode* bn : getChildNodes())
 	{
@@ -153,21 +156,24 @@ void Camera::SetProjection(GLfloat fov, GLfloat near, GLfloat far, GLfloat w, GL
     float top = tan((fov/2.0)*(glm::pi<float>()/180.0))*near;
     float right = top * w/h;
     mProjectionMatrix = glm::frustum(-right, right, -top, top, near, far);
+    mPixelsPerUnit = h / (2.0f * tan((fov/2.0)*(glm::pi<float>()/180.0)));
 }
 
 
-void Camera::SetupShader(GLuint program, glm::mat4& parentTransf){
+void Camera::SetupFrame(FrameUniforms& frame){
 
-    // update view matrix
+    // update view matrix, once for the frame
     SetupViewMatrix();
 
-    // Set view matrix in shader
-    GLint view_mat = glGetUniformLocation(program, "view_mat");
-    glUniformMatrix4fv(view_mat, 1, GL_FALSE, glm::value_ptr(mViewMatrix));
-    
-    // Set projection matrix in shader
-    GLint projection_mat = glGetUniformLocation(program, "projection_mat");
-    glUniformMatrix4fv(projection_mat, 1, GL_FALSE, glm::value_ptr(mProjectionMatrix));
+    frame.view = mViewMatrix;
+    frame.projection = mProjectionMatrix;
+    frame.cameraPosition = glm::vec4(mPosition, 1.0f);
+
+    // Size of a unit on screen, for point sprites
+    frame.pixelsPerUnit = mPixelsPerUnit;
+
+    // Timer, the same game time for every node drawn this frame
+    frame.time = (float) mFrameTime;
 }
 
 
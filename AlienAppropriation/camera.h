@@ -11,6 +11,7 @@
 #include <string>
 
 #include "scene_node.h"
+#include "uniform_buffers.h"
 
 
 namespace game {
@@ -41,6 +42,10 @@ namespace game {
 
 			Perspective mCameraPerspective;
 
+			float mPixelsPerUnit; // Height in pixels of one unit at distance one, for level of detail
+
+			double mFrameTime; // Game time of the frame being drawn
+
         public:
             Camera(std::string name);
             ~Camera();
@@ -81,10 +86,14 @@ namespace game {
             // Set projection from frustum parameters: field-of-view,
             // near and far planes, and width and height of viewport
             void SetProjection(GLfloat fov, GLfloat near, GLfloat far, GLfloat w, GLfloat h);
-            // Set all camera-related variables in shader program
-            virtual void SetupShader(GLuint program, glm::mat4& parentTransf = glm::mat4(1.0));
+            // Fill in the camera's part of the per-frame shader data: view, projection, position, time
+            void SetupFrame(FrameUniforms& frame);
+
+			// Game time handed to the shaders, set once per frame from the GameClock
+			inline void setFrameTime(double time) { mFrameTime = time; }
 
 			inline float GetHeight() { return mPosition.y; };
+			inline float GetPixelsPerUnit() const { return mPixelsPerUnit; }
 
 
 
@@ -0,0 +1,524 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLISION_SSE2 1
+#endif
+
+#include "collision.h"
+
+namespace game {
+
+// Moves shorter than this (squared) are treated as standing still
+const float min_sweep2_g = 1e-12f;
+
+// Capsule against box walks the closest points back and forth this many times
+// Both are convex so it closes in on the true distance, a few steps are plenty at the sizes the game uses
+const int capsule_box_steps_g = 4;
+
+// Added to the rotation terms of the box test, so boxes with parallel edges don't hide behind a zero cross product
+const float box_parallel_epsilon_g = 1e-5f;
+
+
+static void CapsuleSegment(const CollisionShape& capsule, glm::vec3& a, glm::vec3& b)
+{
+	a = capsule.center - capsule.axes[1] * capsule.extents.y;
+	b = capsule.center + capsule.axes[1] * capsule.extents.y;
+}
+
+static glm::vec3 ClosestOnSegment(glm::vec3 p, glm::vec3 a, glm::vec3 b)
+{
+	glm::vec3 ab = b - a;
+	float length2 = glm::dot(ab, ab);
+	if (length2 < min_sweep2_g)
+		return a;
+	float t = glm::clamp(glm::dot(p - a, ab) / length2, 0.0f, 1.0f);
+	return a + t * ab;
+}
+
+static glm::vec3 ClosestInBox(glm::vec3 p, const CollisionShape& box)
+{
+	glm::vec3 d = p - box.center;
+	glm::vec3 q = box.center;
+	for (int i = 0; i < 3; i++) {
+		q += glm::clamp(glm::dot(d, box.axes[i]), -box.extents[i], box.extents[i]) * box.axes[i];
+	}
+	return q;
+}
+
+// Squared distance between the segments p1-q1 and p2-q2
+// From Ericson, Real-Time Collision Detection, 5.1.9
+static float SegmentDistance2(glm::vec3 p1, glm::vec3 q1, glm::vec3 p2, glm::vec3 q2)
+{
+	glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+	float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+	float s, t;
+
+	if (a < min_sweep2_g && e < min_sweep2_g) {
+		s = t = 0.0f;
+	}
+	else if (a < min_sweep2_g) {
+		s = 0.0f;
+		t = glm::clamp(f / e, 0.0f, 1.0f);
+	}
+	else {
+		float c = glm::dot(d1, r);
+		if (e < min_sweep2_g) {
+			t = 0.0f;
+			s = glm::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else {
+			float b = glm::dot(d1, d2);
+			float denom = a * e - b * b;
+			s = denom > 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = glm::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f) {
+				t = 1.0f;
+				s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	glm::vec3 d = (p1 + d1 * s) - (p2 + d2 * t);
+	return glm::dot(d, d);
+}
+
+// Separating axis test between two oriented boxes: their 3 + 3 face normals and the 9 edge cross products
+static bool BoxesOverlap(const CollisionShape& a, const CollisionShape& b)
+{
+	float r[3][3], absR[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			r[i][j] = glm::dot(a.axes[i], b.axes[j]);
+			absR[i][j] = std::fabs(r[i][j]) + box_parallel_epsilon_g;
+		}
+	}
+
+	// b's center in a's frame
+	glm::vec3 d = b.center - a.center;
+	float t[3] = { glm::dot(d, a.axes[0]), glm::dot(d, a.axes[1]), glm::dot(d, a.axes[2]) };
+
+	for (int i = 0; i < 3; i++) {
+		float rb = b.extents[0] * absR[i][0] + b.extents[1] * absR[i][1] + b.extents[2] * absR[i][2];
+		if (std::fabs(t[i]) > a.extents[i] + rb)
+			return false;
+	}
+	for (int j = 0; j < 3; j++) {
+		float ra = a.extents[0] * absR[0][j] + a.extents[1] * absR[1][j] + a.extents[2] * absR[2][j];
+		if (std::fabs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ra + b.extents[j])
+			return false;
+	}
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			float ra = a.extents[i1] * absR[i2][j] + a.extents[i2] * absR[i1][j];
+			float rb = b.extents[j1] * absR[i][j2] + b.extents[j2] * absR[i][j1];
+			if (std::fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+				return false;
+		}
+	}
+	return true;
+}
+
+float BoundingRadius(const CollisionShape& shape)
+{
+	switch (shape.type) {
+	case Capsule:
+		return shape.extents.y + shape.radius;
+	case Box:
+		return glm::length(shape.extents);
+	default:
+		return shape.radius;
+	}
+}
+
+bool Overlap(const CollisionShape& a, const CollisionShape& b)
+{
+	if (a.type == None || b.type == None)
+		return false;
+
+	// Only one order of every combination is written out: points, then capsules, then boxes
+	if (a.type > b.type)
+		return Overlap(b, a);
+
+	glm::vec3 a0, a1, b0, b1, d;
+	float r = a.radius + b.radius;
+	switch (a.type) {
+	case Point:
+		if (b.type == Point) {
+			d = a.center - b.center;
+		}
+		else if (b.type == Capsule) {
+			CapsuleSegment(b, b0, b1);
+			d = a.center - ClosestOnSegment(a.center, b0, b1);
+		}
+		else {
+			d = a.center - ClosestInBox(a.center, b);
+			r = a.radius;
+		}
+		return glm::dot(d, d) <= r * r;
+
+	case Capsule:
+		CapsuleSegment(a, a0, a1);
+		if (b.type == Capsule) {
+			CapsuleSegment(b, b0, b1);
+			return SegmentDistance2(a0, a1, b0, b1) <= r * r;
+		}
+		else {
+			glm::vec3 p = ClosestOnSegment(b.center, a0, a1);
+			glm::vec3 q = ClosestInBox(p, b);
+			for (int i = 0; i < capsule_box_steps_g; i++) {
+				p = ClosestOnSegment(q, a0, a1);
+				q = ClosestInBox(p, b);
+			}
+			d = p - q;
+			return glm::dot(d, d) <= a.radius * a.radius;
+		}
+
+	default:
+		return BoxesOverlap(a, b);
+	}
+}
+
+
+void Narrowphase::add(const CollisionShape& a, const CollisionShape& b, int id)
+{
+	if (a.type == None || b.type == None)
+		return;
+	if (a.type > b.type) {
+		add(b, a, id);
+		return;
+	}
+
+	if (a.type != Point) {
+		mPairs.push_back({ a, b, id });
+		return;
+	}
+
+	glm::vec3 p = a.center;
+	if (b.type == Point) {
+		mSpheres.ax.push_back(p.x); mSpheres.ay.push_back(p.y); mSpheres.az.push_back(p.z);
+		mSpheres.bx.push_back(b.center.x); mSpheres.by.push_back(b.center.y); mSpheres.bz.push_back(b.center.z);
+		mSpheres.r.push_back(a.radius + b.radius);
+		mSpheres.id.push_back(id);
+	}
+	else if (b.type == Capsule) {
+		glm::vec3 s0, s1;
+		CapsuleSegment(b, s0, s1);
+		glm::vec3 d = s1 - s0;
+		mCapsules.px.push_back(p.x); mCapsules.py.push_back(p.y); mCapsules.pz.push_back(p.z);
+		mCapsules.ax.push_back(s0.x); mCapsules.ay.push_back(s0.y); mCapsules.az.push_back(s0.z);
+		mCapsules.dx.push_back(d.x); mCapsules.dy.push_back(d.y); mCapsules.dz.push_back(d.z);
+		mCapsules.invLength2.push_back(1.0f / std::max(glm::dot(d, d), min_sweep2_g));
+		mCapsules.r.push_back(a.radius + b.radius);
+		mCapsules.id.push_back(id);
+	}
+	else {
+		glm::vec3 o = p - b.center;
+		mBoxes.ox.push_back(o.x); mBoxes.oy.push_back(o.y); mBoxes.oz.push_back(o.z);
+		mBoxes.ux.push_back(b.axes[0].x); mBoxes.uy.push_back(b.axes[0].y); mBoxes.uz.push_back(b.axes[0].z);
+		mBoxes.vx.push_back(b.axes[1].x); mBoxes.vy.push_back(b.axes[1].y); mBoxes.vz.push_back(b.axes[1].z);
+		mBoxes.wx.push_back(b.axes[2].x); mBoxes.wy.push_back(b.axes[2].y); mBoxes.wz.push_back(b.axes[2].z);
+		mBoxes.ex.push_back(b.extents.x); mBoxes.ey.push_back(b.extents.y); mBoxes.ez.push_back(b.extents.z);
+		mBoxes.r.push_back(a.radius);
+		mBoxes.id.push_back(id);
+	}
+}
+
+void Narrowphase::clear()
+{
+	mSpheres = SphereBatch();
+	mCapsules = CapsuleBatch();
+	mBoxes = BoxBatch();
+	mPairs.clear();
+}
+
+void Narrowphase::run(std::vector<int>& hits) const
+{
+	runSpheres(mSpheres, hits);
+	runCapsules(mCapsules, hits);
+	runBoxes(mBoxes, hits);
+	for (const Pair& pair : mPairs) {
+		if (Overlap(pair.a, pair.b))
+			hits.push_back(pair.id);
+	}
+}
+
+// Each kernel does four pairs at a time while it can and finishes with the same test one pair at a time
+
+void Narrowphase::runSpheres(const SphereBatch& b, std::vector<int>& hits)
+{
+	int count = (int)b.id.size();
+	int i = 0;
+
+#if COLLISION_SSE2
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&b.ax[i]), _mm_loadu_ps(&b.bx[i]));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&b.ay[i]), _mm_loadu_ps(&b.by[i]));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&b.az[i]), _mm_loadu_ps(&b.bz[i]));
+		__m128 r = _mm_loadu_ps(&b.r[i]);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(r, r)));
+		for (int lane = 0; mask; lane++, mask >>= 1)
+		{
+			if (mask & 1) hits.push_back(b.id[i + lane]);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float dx = b.ax[i] - b.bx[i], dy = b.ay[i] - b.by[i], dz = b.az[i] - b.bz[i];
+		if (dx * dx + dy * dy + dz * dz <= b.r[i] * b.r[i])
+			hits.push_back(b.id[i]);
+	}
+}
+
+void Narrowphase::runCapsules(const CapsuleBatch& b, std::vector<int>& hits)
+{
+	int count = (int)b.id.size();
+	int i = 0;
+
+#if COLLISION_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_loadu_ps(&b.dx[i]), dy = _mm_loadu_ps(&b.dy[i]), dz = _mm_loadu_ps(&b.dz[i]);
+		__m128 ox = _mm_sub_ps(_mm_loadu_ps(&b.px[i]), _mm_loadu_ps(&b.ax[i]));
+		__m128 oy = _mm_sub_ps(_mm_loadu_ps(&b.py[i]), _mm_loadu_ps(&b.ay[i]));
+		__m128 oz = _mm_sub_ps(_mm_loadu_ps(&b.pz[i]), _mm_loadu_ps(&b.az[i]));
+
+		// Closest point on the segment to the sphere's center, as a fraction along it
+		__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, dx), _mm_mul_ps(oy, dy)), _mm_mul_ps(oz, dz));
+		t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(t, _mm_loadu_ps(&b.invLength2[i])), zero), one);
+
+		ox = _mm_sub_ps(ox, _mm_mul_ps(t, dx));
+		oy = _mm_sub_ps(oy, _mm_mul_ps(t, dy));
+		oz = _mm_sub_ps(oz, _mm_mul_ps(t, dz));
+		__m128 r = _mm_loadu_ps(&b.r[i]);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(r, r)));
+		for (int lane = 0; mask; lane++, mask >>= 1)
+		{
+			if (mask & 1) hits.push_back(b.id[i + lane]);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float ox = b.px[i] - b.ax[i], oy = b.py[i] - b.ay[i], oz = b.pz[i] - b.az[i];
+		float t = (ox * b.dx[i] + oy * b.dy[i] + oz * b.dz[i]) * b.invLength2[i];
+		t = std::min(std::max(t, 0.0f), 1.0f);
+		ox -= t * b.dx[i];
+		oy -= t * b.dy[i];
+		oz -= t * b.dz[i];
+		if (ox * ox + oy * oy + oz * oz <= b.r[i] * b.r[i])
+			hits.push_back(b.id[i]);
+	}
+}
+
+void Narrowphase::runBoxes(const BoxBatch& b, std::vector<int>& hits)
+{
+	int count = (int)b.id.size();
+	int i = 0;
+
+#if COLLISION_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 ox = _mm_loadu_ps(&b.ox[i]), oy = _mm_loadu_ps(&b.oy[i]), oz = _mm_loadu_ps(&b.oz[i]);
+
+		// The sphere's center in the box's frame, then how far outside the box it is along each axis
+		__m128 lu = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, _mm_loadu_ps(&b.ux[i])), _mm_mul_ps(oy, _mm_loadu_ps(&b.uy[i]))), _mm_mul_ps(oz, _mm_loadu_ps(&b.uz[i])));
+		__m128 lv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, _mm_loadu_ps(&b.vx[i])), _mm_mul_ps(oy, _mm_loadu_ps(&b.vy[i]))), _mm_mul_ps(oz, _mm_loadu_ps(&b.vz[i])));
+		__m128 lw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, _mm_loadu_ps(&b.wx[i])), _mm_mul_ps(oy, _mm_loadu_ps(&b.wy[i]))), _mm_mul_ps(oz, _mm_loadu_ps(&b.wz[i])));
+		__m128 eu = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, lu), _mm_loadu_ps(&b.ex[i])), zero);
+		__m128 ev = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, lv), _mm_loadu_ps(&b.ey[i])), zero);
+		__m128 ew = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, lw), _mm_loadu_ps(&b.ez[i])), zero);
+		__m128 r = _mm_loadu_ps(&b.r[i]);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(eu, eu), _mm_mul_ps(ev, ev)), _mm_mul_ps(ew, ew));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(r, r)));
+		for (int lane = 0; mask; lane++, mask >>= 1)
+		{
+			if (mask & 1) hits.push_back(b.id[i + lane]);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float lu = b.ox[i] * b.ux[i] + b.oy[i] * b.uy[i] + b.oz[i] * b.uz[i];
+		float lv = b.ox[i] * b.vx[i] + b.oy[i] * b.vy[i] + b.oz[i] * b.vz[i];
+		float lw = b.ox[i] * b.wx[i] + b.oy[i] * b.wy[i] + b.oz[i] * b.wz[i];
+		float eu = std::max(std::fabs(lu) - b.ex[i], 0.0f);
+		float ev = std::max(std::fabs(lv) - b.ey[i], 0.0f);
+		float ew = std::max(std::fabs(lw) - b.ez[i], 0.0f);
+		if (eu * eu + ev * ev + ew * ew <= b.r[i] * b.r[i])
+			hits.push_back(b.id[i]);
+	}
+}
+
+
+// First time in [0, 1] at which the point 'origin' + t * 'd' is within 'r' of 'center', -1 if never
+static float SweepPoint(glm::vec3 origin, glm::vec3 d, glm::vec3 center, float r)
+{
+	glm::vec3 oc = origin - center;
+	float c = glm::dot(oc, oc) - r * r;
+	if (c <= 0.0f)
+		return 0.0f;
+
+	float a = glm::dot(d, d);
+	if (a < min_sweep2_g)
+		return -1.0f;
+
+	float b = glm::dot(oc, d);
+	float h = b * b - a * c;
+	if (b >= 0.0f || h < 0.0f)
+		return -1.0f;
+
+	float t = (-b - std::sqrt(h)) / a;
+	return t <= 1.0f ? t : -1.0f;
+}
+
+float SweepSphere(glm::vec3 start, glm::vec3 end, float radius, glm::vec3 targetStart, glm::vec3 targetEnd, float targetRadius)
+{
+	// Relative to the target, which then stands still at the origin
+	glm::vec3 origin = start - targetStart;
+	glm::vec3 d = (end - targetEnd) - origin;
+	return SweepPoint(origin, d, glm::vec3(0.0f), radius + targetRadius);
+}
+
+float SweepCapsule(glm::vec3 start, glm::vec3 end, float radius, glm::vec3 a, glm::vec3 b, float targetRadius)
+{
+	float r = radius + targetRadius;
+	glm::vec3 d = end - start;
+
+	// The capsule is the union of its two end spheres and the cylinder between them,
+	// so the first contact is the earliest contact with any of the three
+	float toi = -1.0f;
+	float caps[2] = { SweepPoint(start, d, a, r), SweepPoint(start, d, b, r) };
+	for (float t : caps) {
+		if (t >= 0.0f && (toi < 0.0f || t < toi))
+			toi = t;
+	}
+
+	// Cylinder around the segment, written out with the axis length unnormalised
+	glm::vec3 ba = b - a;
+	glm::vec3 oa = start - a;
+	float baba = glm::dot(ba, ba);
+	float bad = glm::dot(ba, d);
+	float baoa = glm::dot(ba, oa);
+	float qa = baba * glm::dot(d, d) - bad * bad;
+	float qb = baba * glm::dot(d, oa) - baoa * bad;
+	float qc = baba * glm::dot(oa, oa) - baoa * baoa - r * r * baba;
+
+	if (baba > 0.0f) {
+		// Starting inside the cylinder part
+		if (qc <= 0.0f && baoa > 0.0f && baoa < baba)
+			return 0.0f;
+
+		float h = qb * qb - qa * qc;
+		if (qa > min_sweep2_g && h >= 0.0f) {
+			float t = (-qb - std::sqrt(h)) / qa;
+			float y = baoa + t * bad;
+			if (t >= 0.0f && t <= 1.0f && y > 0.0f && y < baba && (toi < 0.0f || t < toi))
+				toi = t;
+		}
+	}
+
+	return toi;
+}
+
+float SweepBox(glm::vec3 start, glm::vec3 end, float radius, const CollisionShape& box)
+{
+	// Slabs of the grown box along each of its axes, the sphere is inside once it is between all three pairs
+	glm::vec3 o = start - box.center;
+	glm::vec3 d = end - start;
+	float enter = 0.0f, exit = 1.0f;
+	for (int i = 0; i < 3; i++) {
+		float p = glm::dot(o, box.axes[i]);
+		float v = glm::dot(d, box.axes[i]);
+		float e = box.extents[i] + radius;
+
+		if (std::fabs(v) < min_sweep2_g) {
+			if (std::fabs(p) > e)
+				return -1.0f;
+			continue;
+		}
+
+		float t0 = (-e - p) / v, t1 = (e - p) / v;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		enter = std::max(enter, t0);
+		exit = std::min(exit, t1);
+		if (enter > exit)
+			return -1.0f;
+	}
+	return enter;
+}
+
+
+void SweepBatch::add(glm::vec3 start, glm::vec3 end, float r)
+{
+	startX.push_back(start.x); startY.push_back(start.y); startZ.push_back(start.z);
+	endX.push_back(end.x); endY.push_back(end.y); endZ.push_back(end.z);
+	radius.push_back(r);
+}
+
+void SweepBatch::clear()
+{
+	startX.clear(); startY.clear(); startZ.clear();
+	endX.clear(); endY.clear(); endZ.clear();
+	radius.clear();
+}
+
+void SweepBatchSphere(const SweepBatch& batch, glm::vec3 targetStart, glm::vec3 targetEnd, float targetRadius, std::vector<Contact>& contacts)
+{
+	int count = batch.getCount();
+	std::vector<float> toi(count);
+
+	// Same maths as SweepSphere without branches, so the loop vectorises
+	for (int i = 0; i < count; i++)
+	{
+		float ox = batch.startX[i] - targetStart.x;
+		float oy = batch.startY[i] - targetStart.y;
+		float oz = batch.startZ[i] - targetStart.z;
+		float dx = (batch.endX[i] - targetEnd.x) - ox;
+		float dy = (batch.endY[i] - targetEnd.y) - oy;
+		float dz = (batch.endZ[i] - targetEnd.z) - oz;
+		float r = batch.radius[i] + targetRadius;
+
+		float a = dx * dx + dy * dy + dz * dz;
+		float b = ox * dx + oy * dy + oz * dz;
+		float c = ox * ox + oy * oy + oz * oz - r * r;
+		float h = b * b - a * c;
+
+		// Entering: the quadratic has roots, the sphere is moving closer and the first root is within the tick
+		float t = (-b - std::sqrt(std::max(h, 0.0f))) / std::max(a, min_sweep2_g);
+		bool entering = h >= 0.0f && b < 0.0f && a >= min_sweep2_g && t <= 1.0f;
+		toi[i] = c <= 0.0f ? 0.0f : (entering ? t : -1.0f);
+	}
+
+	size_t first = contacts.size();
+	for (int i = 0; i < count; i++)
+	{
+		if (toi[i] >= 0.0f)
+			contacts.push_back({ i, toi[i] });
+	}
+	std::sort(contacts.begin() + first, contacts.end());
+}
+
+} // namespace game
@@ -0,0 +1,125 @@
+#ifndef COLLISION_H_
+#define COLLISION_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace game {
+
+	enum CollisionType { Point, Capsule, Box, None };
+
+	// struct CollisionShape
+	// A node's collision volume in world space, see SceneNode::getCollisionShape
+	// Points are spheres of 'radius' around 'center'. Boxes are centered on 'center', face along 'axes'
+	// and are 'extents' wide either side. Capsules are the segment between center - axes[1] * extents.y
+	// and center + axes[1] * extents.y, grown by 'radius'.
+	struct CollisionShape {
+		CollisionType type;
+		glm::vec3 center;
+		glm::vec3 axes[3];	// Unit length and at right angles
+		glm::vec3 extents;
+		float radius;
+	};
+
+	// Radius of a sphere around the shape's center holding all of it
+	float BoundingRadius(const CollisionShape& shape);
+
+	// Whether 'a' and 'b' overlap, one pair at a time
+	bool Overlap(const CollisionShape& a, const CollisionShape& b);
+
+	// class Narrowphase
+	// Exact tests for the pairs that got past the grid, queued over the tick and run in one go.
+	// Pairs are filed by the shapes involved as they are queued, so the common ones (a sphere against a
+	// sphere, a capsule or a box) sit in arrays of their own and are tested four at a time with SSE2.
+	// Everything else goes through Overlap.
+	class Narrowphase {
+
+	public:
+		// Queue a test between 'a' and 'b', 'id' is handed back by run if they overlap
+		void add(const CollisionShape& a, const CollisionShape& b, int id);
+		// Test every queued pair and append the ids of those that overlap to 'hits', in no particular order
+		void run(std::vector<int>& hits) const;
+		void clear();
+
+		inline int getCount() const { return (int)(mSpheres.id.size() + mCapsules.id.size() + mBoxes.id.size() + mPairs.size()); }
+
+	private:
+		// A sphere against a sphere: both centers and the sum of the radii
+		struct SphereBatch {
+			std::vector<float> ax, ay, az, bx, by, bz, r;
+			std::vector<int> id;
+		};
+
+		// A sphere against a capsule: the sphere's center, where the segment starts, its direction and
+		// one over its squared length, and the sum of the radii
+		struct CapsuleBatch {
+			std::vector<float> px, py, pz, ax, ay, az, dx, dy, dz, invLength2, r;
+			std::vector<int> id;
+		};
+
+		// A sphere against a box: the sphere's center relative to the box's, the box axes and extents, the sphere's radius
+		struct BoxBatch {
+			std::vector<float> ox, oy, oz, ux, uy, uz, vx, vy, vz, wx, wy, wz, ex, ey, ez, r;
+			std::vector<int> id;
+		};
+
+		struct Pair {
+			CollisionShape a, b;
+			int id;
+		};
+
+		SphereBatch mSpheres;
+		CapsuleBatch mCapsules;
+		BoxBatch mBoxes;
+		std::vector<Pair> mPairs;
+
+		static void runSpheres(const SphereBatch& b, std::vector<int>& hits);
+		static void runCapsules(const CapsuleBatch& b, std::vector<int>& hits);
+		static void runBoxes(const BoxBatch& b, std::vector<int>& hits);
+
+	}; // class Narrowphase
+
+	// Continuous collision tests
+	// Objects are spheres swept from where they were at the start of the tick to where they are at the end,
+	// so a fast missile or a falling bomb can't skip over something between two ticks.
+	// Times of impact are fractions of the tick: 0 is the start, 1 the end, and -1 means no contact.
+
+	// A sphere of 'radius' moving from 'start' to 'end' against a sphere of 'targetRadius' moving from
+	// 'targetStart' to 'targetEnd' over the same tick. Spheres already touching at the start hit at 0
+	float SweepSphere(glm::vec3 start, glm::vec3 end, float radius, glm::vec3 targetStart, glm::vec3 targetEnd, float targetRadius);
+
+	// A sphere of 'radius' moving from 'start' to 'end' against a capsule: the segment a-b grown by 'targetRadius'
+	float SweepCapsule(glm::vec3 start, glm::vec3 end, float radius, glm::vec3 a, glm::vec3 b, float targetRadius);
+
+	// A sphere of 'radius' moving from 'start' to 'end' against a box that stands still
+	// The box is grown by 'radius' on every side, so near its edges and corners the sphere hits a little early
+	float SweepBox(glm::vec3 start, glm::vec3 end, float radius, const CollisionShape& box);
+
+	// struct SweepBatch
+	// Many swept spheres at once, one array per component like the EntityStore
+	struct SweepBatch {
+		std::vector<float> startX, startY, startZ;
+		std::vector<float> endX, endY, endZ;
+		std::vector<float> radius;
+
+		inline int getCount() const { return (int)radius.size(); }
+		void add(glm::vec3 start, glm::vec3 end, float r);
+		void clear();
+	};
+
+	// struct Contact
+	// A sweep from a batch that touched the target, and when
+	struct Contact {
+		int index;		// Position in the batch
+		float toi;		// Time of impact
+
+		inline bool operator<(const Contact& other) const { return toi < other.toi; }
+	};
+
+	// Sweep every sphere of the batch against one moving sphere
+	// Hits are appended to 'contacts' in the order they happened during the tick
+	void SweepBatchSphere(const SweepBatch& batch, glm::vec3 targetStart, glm::vec3 targetEnd, float targetRadius, std::vector<Contact>& contacts);
+
+} // namespace game
+
+#endif // COLLISION_H_
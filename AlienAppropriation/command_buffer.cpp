@@ -0,0 +1,32 @@
+#include "command_buffer.h"
+#include "job_system.h"
+
+namespace game {
+
+std::vector<std::vector<std::function<void()>>> CommandBuffer::mBuffers(1);
+
+
+void CommandBuffer::setThreadCount(int threadCount)
+{
+	// Commands already recorded are kept
+	if (threadCount > (int)mBuffers.size())
+		mBuffers.resize(threadCount);
+}
+
+void CommandBuffer::push(std::function<void()> command)
+{
+	mBuffers[JobSystem::getThreadIndex()].push_back(command);
+}
+
+void CommandBuffer::flush()
+{
+	// Commands may record new commands (e.g. a spawn that deletes something), so index rather than iterate
+	for (std::vector<std::function<void()>>& buffer : mBuffers) {
+		for (size_t i = 0; i < buffer.size(); i++) {
+			buffer[i]();
+		}
+		buffer.clear();
+	}
+}
+
+} // namespace game
@@ -0,0 +1,31 @@
+#ifndef COMMAND_BUFFER_H_
+#define COMMAND_BUFFER_H_
+
+#include <vector>
+#include <functional>
+
+namespace game {
+
+	// class CommandBuffer
+	// Changes to the scene requested during the parallel update phase (spawning, deleting, damaging the player)
+	// Each thread records into its own buffer, so no locking is needed while recording
+	// The buffers are applied on the main thread at the sync point, in thread order
+	class CommandBuffer {
+
+	public:
+		static void setThreadCount(int threadCount);
+
+		// Record a command from the calling thread
+		static void push(std::function<void()> command);
+
+		// Run and clear every recorded command, main thread only
+		static void flush();
+
+	private:
+		static std::vector<std::vector<std::function<void()>>> mBuffers;
+
+	}; // class CommandBuffer
+
+} // namespace game
+
+#endif // COMMAND_BUFFER_H_
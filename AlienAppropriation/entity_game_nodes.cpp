@@ -4,6 +4,7 @@
 #include "projectile_node.h"
 
 #include "scene_graph.h"
+#include "command_buffer.h"
 
 namespace game
 {
@@ -11,23 +12,23 @@ namespace game
 
 CowEntityNode::CowEntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture) 
 	: EntityNode(name, geometry, material, texture)
-	, mLastTimer(0.0f)
-	, mNextTimer(0.0f)
 {
 	addTag("canPickUp");
 	addTag("cow");
 	addTag("canCollect");
 
-	int defaultBehaviour = rand() % 2;
+	int defaultBehaviour = mRandom.range(2);
 	switch (defaultBehaviour)
 	{
 	case 0:
-		mBehaviour = stand;
+		setBehaviour(stand);
 		break;
 	case 1:
-		mBehaviour = walk;
+		setBehaviour(walk);
 		break;
 	}
+
+	setTimer(mRandom.uniform(2.0f, 6.0f));
 }
 
 CowEntityNode::~CowEntityNode()
@@ -35,84 +36,80 @@ CowEntityNode::~CowEntityNode()
 
 }
 
-void CowEntityNode::update(double deltaTime)
+void CowEntityNode::think(const TickContext& ctx)
 {
-	EntityNode::update(deltaTime);
-
 	// Basic Cow should walk around occasionally, and stop occasionally
 	// This behaviors repeats indefinitely
 	// If a cow is picked up and then dropped, it should run around erratically for some time, before stopping and continuing normal behavior
 
-	// Behaviour state timer stuff
-	float currentTime = glfwGetTime();
-	if (currentTime >= mNextTimer)
-	{
-		if (mNextTimer != 0.0f)
-		{
-			if (mBehaviour == stand)
-				mBehaviour = walk;
-			else if (mBehaviour == walk)
-				mBehaviour = stand;
-			else if (mBehaviour == run)
-				mBehaviour = stand;
-		}
-
-		mLastTimer = currentTime;
-
-		float minPeriod = 2.0f;
-		float maxPeriod = 6.0f;
-
-		mNextTimer = currentTime + minPeriod + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / maxPeriod - minPeriod);
-	}
+	// Behaviour changes happen in onTimer, this only runs while walking or running
+	Behaviour behaviour = (Behaviour)getBehaviourState();
 
 	// Behaviour Stuff
-	if (mIsGrounded)
+	if (getIsGrounded())
 	{
-		if (mBehaviour == stand)
-			doStand();
-		else if (mBehaviour == walk)
+		if (behaviour == walk)
 			doWalk();
-		else if (mBehaviour == run)
+		else if (behaviour == run)
 			doRun();
 	}
 
 }
 
-void CowEntityNode::hitGround()
+void CowEntityNode::onTimer(const TickContext& ctx)
 {
-	mBehaviour = run;
-	mNextTimer = glfwGetTime() + 6.0f;
+	// Flip between standing and walking, running always ends in a stand
+	Behaviour behaviour = (Behaviour)getBehaviourState();
+	if (behaviour == stand)
+		setBehaviour(walk);
+	else
+		setBehaviour(stand);
+
+	float minPeriod = 2.0f;
+	float maxPeriod = 6.0f;
+
+	setTimer(mRandom.uniform(minPeriod, maxPeriod));
+}
+
+void CowEntityNode::hitGround(const TickContext& ctx)
+{
+	setBehaviour(run);
+	setTimer(6.0);
+}
+
+void CowEntityNode::setBehaviour(Behaviour behaviour)
+{
+	setBehaviourState(behaviour);
+
+	// Standing needs no work until the next timer, moving steers every tick
+	if (behaviour == stand && getIsGrounded())
+		doStand();
+	setThinking(behaviour != stand);
 }
 
 void CowEntityNode::doStand()
 {
-	mVelocity = glm::vec3(0.0f);
+	setVelocity(glm::vec3(0.0f));
 }
 
 void CowEntityNode::doWalk()
 {
-	glm::vec3 dirVec = glm::vec3(
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f))),
-		0.0f,
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f)))
-	);
-
-	mVelocity += 0.02f * glm::normalize(dirVec);
-	mVelocity = 0.2f * glm::normalize(mVelocity);
-	rotate(mVelocity);
+	glm::vec3 dirVec = glm::vec3(mRandom.uniform(-1.0f, 1.0f), 0.0f, mRandom.uniform(-1.0f, 1.0f));
+
+	glm::vec3 velocity = getVelocity() + 0.02f * glm::normalize(dirVec);
+	velocity = 0.2f * glm::normalize(velocity);
+	setVelocity(velocity);
+	rotate(velocity);
 }
 
 void CowEntityNode::doRun()
 {
-	glm::vec3 dirVec = glm::vec3(
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f))),
-		0.0f,
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f)))
-	);
-
-	mVelocity += 0.2f * glm::normalize(dirVec);
-	mVelocity = 0.5f * glm::normalize(mVelocity);
-	rotate(mVelocity);
+	glm::vec3 dirVec = glm::vec3(mRandom.uniform(-1.0f, 1.0f), 0.0f, mRandom.uniform(-1.0f, 1.0f));
+
+	glm::vec3 velocity = getVelocity() + 0.2f * glm::normalize(dirVec);
+	velocity = 0.5f * glm::normalize(velocity);
+	setVelocity(velocity);
+	rotate(velocity);
 }
 
 
@@ -121,25 +118,25 @@ void CowEntityNode::doRun()
 
 BullEntityNode::BullEntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture /*= NULL*/)
 	: EntityNode(name, geometry, material, texture)
-	, mLastTimer(0.0f)
-	, mNextTimer(0.0f)
 {
 
 	addTag("canPickUp");
 	addTag("bull");
 	addTag("canCollect");
 	// Random start behaviour
-	int defaultBehaviour = rand() % 2;
+	int defaultBehaviour = mRandom.range(2);
 	switch (defaultBehaviour)
 	{
 	case 0: 
-		mBehaviour = stand;
+		setBehaviour(stand);
 		break;
 	case 1: 
-		mBehaviour = walk;
+		setBehaviour(walk);
 		break;
 	}
 
+	setTimer(mRandom.uniform(3.0f, 6.0f));
+
 	// Behaviour override
 	//mBehaviour = run;
 }
@@ -150,44 +147,21 @@ BullEntityNode::~BullEntityNode()
 
 }
 
-void BullEntityNode::update(double deltaTime)
+void BullEntityNode::think(const TickContext& ctx)
 {
-	EntityNode::update(deltaTime);
-
 	// Similar to cow
 	// Walks around (but faster) and grazes
 	// Will thrash if picked up and will run for longer when dropped
 
-	//Timer Stuff
-	float currentTime = glfwGetTime();
-	if (currentTime >= mNextTimer)
-	{
-		if (mNextTimer != 0.0f)
-		{
-			if (mBehaviour == stand)
-				mBehaviour = walk;
-			else if (mBehaviour == walk)
-				mBehaviour = stand;
-			else if (mBehaviour == run)
-				mBehaviour = stand;
-		}
-
-		mLastTimer = currentTime;
-
-		float minPeriod = 3.0f;
-		float maxPeriod = 6.0f;
-
-		mNextTimer = currentTime + minPeriod + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / maxPeriod - minPeriod);
-	}
+	// Behaviour changes happen in onTimer, this only runs while walking or running
+	Behaviour behaviour = (Behaviour)getBehaviourState();
 
 	// Behaviour Stuff
-	if (mIsGrounded)
+	if (getIsGrounded())
 	{
-		if (mBehaviour == stand)
-			doStand();
-		else if (mBehaviour == walk)
+		if (behaviour == walk)
 			doWalk();
-		else if (mBehaviour == run)
+		else if (behaviour == run)
 			doRun();
 	}
 
@@ -195,41 +169,60 @@ void BullEntityNode::update(double deltaTime)
 	//When dropped, need to manually set mNextTimer to a greater number than cow
 }
 
-void BullEntityNode::hitGround()
+void BullEntityNode::onTimer(const TickContext& ctx)
 {
-	mBehaviour = run;
-	mNextTimer = glfwGetTime() + 8.0f;
+	// Flip between standing and walking, running always ends in a stand
+	Behaviour behaviour = (Behaviour)getBehaviourState();
+	if (behaviour == stand)
+		setBehaviour(walk);
+	else
+		setBehaviour(stand);
+
+	float minPeriod = 3.0f;
+	float maxPeriod = 6.0f;
+
+	setTimer(mRandom.uniform(minPeriod, maxPeriod));
+}
+
+void BullEntityNode::hitGround(const TickContext& ctx)
+{
+	setBehaviour(run);
+	setTimer(8.0);
+}
+
+void BullEntityNode::setBehaviour(Behaviour behaviour)
+{
+	setBehaviourState(behaviour);
+
+	// Standing needs no work until the next timer, moving steers every tick
+	if (behaviour == stand && getIsGrounded())
+		doStand();
+	setThinking(behaviour != stand);
 }
 
 void BullEntityNode::doStand()
 {
-	mVelocity = glm::vec3(0.0f);
+	setVelocity(glm::vec3(0.0f));
 }
 
 void BullEntityNode::doWalk()
 {
-	glm::vec3 dirVec = glm::vec3(
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f))),
-		0.0f,
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f)))
-	);
-
-	mVelocity += 0.02f * glm::normalize(dirVec);
-	mVelocity = 0.2f * glm::normalize(mVelocity);
-	rotate(mVelocity);
+	glm::vec3 dirVec = glm::vec3(mRandom.uniform(-1.0f, 1.0f), 0.0f, mRandom.uniform(-1.0f, 1.0f));
+
+	glm::vec3 velocity = getVelocity() + 0.02f * glm::normalize(dirVec);
+	velocity = 0.2f * glm::normalize(velocity);
+	setVelocity(velocity);
+	rotate(velocity);
 }
 
 void BullEntityNode::doRun()
 {
-	glm::vec3 dirVec = glm::vec3(
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f))),
-		0.0f,
-		-1.0f + static_cast <float> (rand()) / static_cast <float> (RAND_MAX / (1.0f - (-1.0f)))
-	);
-
-	mVelocity += 0.3f * glm::normalize(dirVec);
-	mVelocity = 0.6f * glm::normalize(mVelocity);
-	rotate(mVelocity);
+	glm::vec3 dirVec = glm::vec3(mRandom.uniform(-1.0f, 1.0f), 0.0f, mRandom.uniform(-1.0f, 1.0f));
+
+	glm::vec3 velocity = getVelocity() + 0.3f * glm::normalize(dirVec);
+	velocity = 0.6f * glm::normalize(velocity);
+	setVelocity(velocity);
+	rotate(velocity);
 }
 
 
@@ -240,9 +233,9 @@ void BullEntityNode::doRun()
 
 FarmerEntityNode::FarmerEntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture /*= NULL*/)
 	: EntityNode(name, geometry, material, texture)
-	, mNextTimer(0.0f)
 {
 	addTag("canPickUp");
+	setThinking(true);
 }
 
 FarmerEntityNode::~FarmerEntityNode()
@@ -250,57 +243,56 @@ FarmerEntityNode::~FarmerEntityNode()
 
 }
 
-void FarmerEntityNode::update(double deltaTime)
+void FarmerEntityNode::think(const TickContext& ctx)
 {
-	EntityNode::update(deltaTime);
-
-
-	glm::vec3 playerPos = SceneGraph::getPlayerNode()->getPosition();
+	glm::vec3 playerPos = ctx.playerPosition;
 	playerPos.y = 0;
 
-	glm::vec3 dirPlayer = playerPos - mPosition;
+	glm::vec3 position = getPosition();
+	glm::vec3 dirPlayer = playerPos - position;
 	dirPlayer.y = 0.0f;
 
 	// If player is within range x, rotate to face player and walk towards until player is within range v
-	if (glm::distance(mPosition, playerPos) < 70.0)
+	if (glm::distance(position, playerPos) < 70.0)
 	{
 		rotate(dirPlayer);
 
-		if (glm::distance(mPosition, playerPos) > 10.0)
-			mVelocity = 0.2f * glm::normalize(dirPlayer);
+		if (glm::distance(position, playerPos) > 10.0)
+			setVelocity(0.2f * glm::normalize(dirPlayer));
 		else
-			mVelocity = glm::vec3(0.0f);
+			setVelocity(glm::vec3(0.0f));
 	}
 	else
-		mVelocity = glm::vec3(0.0f);
+		setVelocity(glm::vec3(0.0f));
 
 	// If player is within range y, and its been atleast z seconds since last shot, fire shotgun at player
 	// Shotgun will auto hit and cant be dodged
-	if (glm::distance(mPosition, playerPos) < 20.0)
+	if (glm::distance(position, playerPos) < 20.0)
 	{
-		float currentTime = glfwGetTime();
-		if (currentTime >= mNextTimer)
+		float currentTime = ctx.time;
+		if (currentTime >= getNextTimer())
 		{
 			doFire();
 
 			// In the meantime, player entity will rise 1 unit.
 			//mPosition.y += 1.0;
 
-			mNextTimer = currentTime + 5.0f;
+			setNextTimer(currentTime + 5.0f);
 		}
 	}
 
 }
 
 
-void FarmerEntityNode::hitGround()
+void FarmerEntityNode::hitGround(const TickContext& ctx)
 {
-	addTag("delete");
+	SceneGraph::destroy(this);
 }
 
 void FarmerEntityNode::doFire()
 {
-	SceneGraph::getPlayerNode()->takeDamage(GUN);
+	// Applied on the main thread at the end of the parallel phase
+	CommandBuffer::push([] { SceneGraph::getPlayerNode()->takeDamage(GUN); });
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -308,11 +300,12 @@ void FarmerEntityNode::doFire()
 
 CannonMissileEntityNode::CannonMissileEntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture /*= NULL*/)
 	: EntityNode(name, geometry, material, texture)
-	, mLastTimer(0.0f)
-	, mNextTimer(15.0f) 
 	, mProjectiles(0)
+	, mLoaded(false)
 {
 	addTag("bombable");
+	setThinking(true);
+	setTimer(15.0);
 }
 
 CannonMissileEntityNode::~CannonMissileEntityNode()
@@ -320,49 +313,58 @@ CannonMissileEntityNode::~CannonMissileEntityNode()
 
 }
 
-void CannonMissileEntityNode::update(double deltaTime)
+void CannonMissileEntityNode::think(const TickContext& ctx)
 {
-	EntityNode::update(deltaTime);
+	glm::vec3 playerPos = ctx.playerPosition;
 
-
-	glm::vec3 playerPos = SceneGraph::getPlayerNode()->getPosition();
-
-	glm::vec3 dirPlayer = playerPos - mPosition;
+	glm::vec3 dirPlayer = playerPos - getPosition();
 	dirPlayer.y = 0.0f;
 
 	rotate(dirPlayer);
 
-	float currentTime = glfwGetTime();
-
-	if (currentTime >= mNextTimer)
+	if (mLoaded)
 	{
-		if (glm::distance(mPosition, playerPos) < 50.0)
+		if (glm::distance(getPosition(), playerPos) < 50.0)
 		{
-			fireHeatMissile();
+			fireHeatMissile(playerPos);
 
-			mLastTimer = currentTime;
-			mNextTimer = currentTime + 15;
+			setLastTimer(ctx.time);
+			mLoaded = false;
 		}
 		
 	}
 
 }
 
-void CannonMissileEntityNode::hitGround()
+void CannonMissileEntityNode::onTimer(const TickContext& ctx)
 {
-	addTag("delete");
+	// Reloaded, fire at the next chance
+	mLoaded = true;
 }
 
-void CannonMissileEntityNode::fireHeatMissile()
+void CannonMissileEntityNode::hitGround(const TickContext& ctx)
 {
-	glm::vec3 playerPos = SceneGraph::getPlayerNode()->getPosition();
+	SceneGraph::destroy(this);
+}
 
-	glm::vec3 dirPlayer = playerPos - mPosition;
+void CannonMissileEntityNode::fireHeatMissile(glm::vec3 playerPos)
+{
+	glm::vec3 position = getPosition();
+	glm::vec3 dirPlayer = playerPos - position;
 	dirPlayer.y = 0.0f;
 
 	glm::vec3 initVelVec = 1.0f * glm::normalize(dirPlayer);
-	HeatMissileNode* missile = SceneGraph::CreateProjectileInstance<HeatMissileNode>(getName() + "missile" + std::to_string(mProjectiles), "missileMesh", "texturedMaterial", "missileTexture", 10, mPosition, initVelVec);
+	std::string missileName = getName() + "missile" + std::to_string(mProjectiles);
 	mProjectiles += 1;
+
+	// Spawning touches the scene graph and the reload timer, so both wait for the sync point
+	// The cannon is looked up again by handle in case something destroyed it before then
+	NodeHandle self = getHandle();
+	CommandBuffer::push([self, missileName, position, initVelVec] {
+		SceneGraph::CreateProjectileInstance<HeatMissileNode>(missileName, "missileMesh", "texturedMaterial", "missileTexture", 10, position, initVelVec);
+		if (CannonMissileEntityNode* cannon = static_cast<CannonMissileEntityNode*>(NodePool::resolve(self)))
+			cannon->setTimer(15.0);
+	});
 	//missile->scale(glm::vec3(0.2, 0.2, 1.5));
 }
 
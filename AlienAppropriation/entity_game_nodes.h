@@ -32,16 +32,18 @@ namespace game {
 		// Destructor
 		~CowEntityNode();
 
-		virtual void update(double deltaTime);
+		virtual void think(const TickContext& ctx);
 
 	private:
 
-		void hitGround();
+		void onTimer(const TickContext& ctx);
+		void hitGround(const TickContext& ctx);
 
 		void doStand();
 		void doWalk();
 		void doRun();
 
+		// Behaviour state and timers are kept in the EntityStore
 		enum Behaviour
 		{
 			walk,
@@ -49,12 +51,8 @@ namespace game {
 			run	
 		};
 
-		Behaviour mBehaviour;
-
-
-		// Timers for behaviors purposes
-		float mLastTimer;
-		float mNextTimer;
+		// Change behaviour and whether the cow needs to think every tick
+		void setBehaviour(Behaviour behaviour);
 
 	}; // class CowEntityNode
 
@@ -71,16 +69,18 @@ namespace game {
 		// Destructor
 		~BullEntityNode();
 
-		void update(double deltaTime);
+		void think(const TickContext& ctx);
 
 	private:
 
-		void hitGround();
+		void onTimer(const TickContext& ctx);
+		void hitGround(const TickContext& ctx);
 
 		void doStand();
 		void doWalk();
 		void doRun();
 
+		// Behaviour state and timers are kept in the EntityStore
 		enum Behaviour
 		{
 			walk,
@@ -89,11 +89,8 @@ namespace game {
 			thrash
 		};
 
-		Behaviour mBehaviour;
-
-		// Timers for behaviors purposes
-		float mLastTimer;
-		float mNextTimer;
+		// Change behaviour and whether the bull needs to think every tick
+		void setBehaviour(Behaviour behaviour);
 
 	}; // class BullEntityNode
 
@@ -110,18 +107,15 @@ namespace game {
 		// Destructor
 		~FarmerEntityNode();
 
-		void update(double deltaTime);
+		void think(const TickContext& ctx);
 		
 
 	private:
 
-		void hitGround();
+		void hitGround(const TickContext& ctx);
 
 		void doFire();
 
-		// Timers for behaviors purposes
-		float mNextTimer;
-
 	}; // class FarmerEntityNode
 
 
@@ -136,21 +130,21 @@ namespace game {
 		// Destructor
 		~CannonMissileEntityNode();
 
-		void update(double deltaTime);
+		void think(const TickContext& ctx);
 
 	private:
 
-		void hitGround();
-
-		void fireHeatMissile();
+		void onTimer(const TickContext& ctx);
+		void hitGround(const TickContext& ctx);
 
-		// Timers for behaviors purposes
-		float mLastTimer;
-		float mNextTimer;
+		void fireHeatMissile(glm::vec3 playerPos);
 
 		// total number of missiles fired by this cannon
 		int mProjectiles;
 
+		// Set by the reload timer, cleared when a missile is fired
+		bool mLoaded;
+
 	}; // class CannonMissileEntityNode
 
 
@@ -1,66 +1,146 @@
 
 #include "entity_node.h"
 #include "player_node.h"
+#include "timer_queue.h"
+#include "scene_graph.h"
+#include "particle_system.h"
 
 namespace game
 {
 
+// Entities within this distance of a landing bomb wake up
+const float bomb_wake_radius_g = 30.0f;
+
+// Straw thrown up by a landing bomb
+const int bomb_debris_g = 600;
+const float bomb_debris_speed_g = 8.0f;
+const glm::vec3 bomb_debris_color_g(0.85f, 0.75f, 0.35f);
+
 
 EntityNode::EntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture)
 	: SceneNode(name, geometry, material, texture)
-	, mVelocity(glm::vec3(0.0f,0.0f,0.0f))
 	, mAcceleration(glm::vec3(0.0f, 0.0f, 0.0f))
-	, mIsGrounded(true)
+	, mTimerGeneration(0)
 {
-
+	mSlot = EntityStore::allocate(this);
 }
 
 EntityNode::~EntityNode()
 {
-
+	releaseSlot();
 }
 
 
 
 void EntityNode::update(double deltaTime)
 {
-	//Apply Gravity
-	if (!mIsGrounded)
-	{
-		if (mPosition.y > 0.0f)
-		{
-			mVelocity += GRAVITY;
-			mVelocity.x = 0.0f;
-			mVelocity.z = 0.0f;
-		}
-		else
-		{
-			mVelocity.y = 0.0f;
-			mPosition.y = 0.0f;
-			mIsGrounded = true;
-			hitGround();
-		}
-	}
+	// Gravity and movement are integrated for all entities at once in EntityStore::integrate
+	// Here we only refresh the grid position and update any children
+	if (isAsleep())
+		return;
+
+	glm::vec3 position = getPosition();
+	gridPosition = glm::vec2(floor(position.x / 15), floor(position.z / 15));
+
+	// Moved by the EntityStore, which doesn't go through the setters
+	markTransformDirty();
+
+	BaseNode::update(deltaTime);
+
+}
+
+void EntityNode::think(const TickContext& ctx)
+{
+	// Plain entities (hay, bombs) have no behaviour of their own
+}
+
+void EntityNode::onTimer(const TickContext& ctx)
+{
+
+}
+
+void EntityNode::setTimer(double delay)
+{
+	TimerQueue::schedule(this, delay);
+}
+
+void EntityNode::cancelTimer()
+{
+	TimerQueue::cancel(this);
+}
+
+glm::vec3 EntityNode::getPosition(void)
+{
+	if (mSlot < 0)
+		return mPosition;
+	return EntityStore::getPosition(mSlot);
+}
+
+glm::vec3 EntityNode::getPreviousPosition(void)
+{
+	if (mSlot < 0)
+		return mPosition;
+	return EntityStore::getPreviousPosition(mSlot);
+}
+
+void EntityNode::setPosition(glm::vec3 position)
+{
+	if (mSlot < 0)
+		mPosition = position;
 	else
-		mVelocity.y = std::max(mVelocity.y, 0.0f);
+		EntityStore::setPosition(mSlot, position);
+	markTransformDirty();
+}
 
-	mPosition += mVelocity;
+void EntityNode::translate(glm::vec3 trans)
+{
+	setPosition(getPosition() + trans);
+}
 
-	SceneNode::update(deltaTime);
+void EntityNode::releaseSlot()
+{
+	if (mSlot < 0)
+		return;
+
+	// Keep the last known position on the node itself
+	mPosition = EntityStore::getPosition(mSlot);
+	EntityStore::release(mSlot);
+	TimerQueue::remove(this);
+	mSlot = -1;
+}
+
+bool EntityNode::isAsleep(void)
+{
+	return mSlot >= 0 && EntityStore::isAsleep(mSlot);
+}
 
+void EntityNode::wake()
+{
+	if (mSlot >= 0)
+		EntityStore::wake(mSlot);
 }
 
 void EntityNode::rise(glm::vec3 dir)
 {
- 	if (mPosition.y == 0.0f)
-		mPosition.y = 0.1f;
-	mVelocity += glm::vec3(0.0, 0.2, 0.0) + -GRAVITY;
+	wake();
+
+	glm::vec3 position = getPosition();
+ 	if (position.y == 0.0f)
+	{
+		position.y = 0.1f;
+		setPosition(position);
+	}
+	setVelocity(getVelocity() + glm::vec3(0.0, 0.2, 0.0) + -GRAVITY);
 	setIsGrounded(false);
 }
 
-void EntityNode::hitGround()
+void EntityNode::hitGround(const TickContext& ctx)
 {
-
+	// A hay bomb landing disturbs everything around it
+	if (hasTag("bomb")) {
+		SceneGraph::wakeArea(getPosition(), bomb_wake_radius_g);
+		ParticleSystem::burst(getPosition(), bomb_debris_g, bomb_debris_speed_g, bomb_debris_color_g, 2.0f);
+	}
 }
 
 }
@@ -5,6 +5,9 @@
 #include <algorithm>
 
 #include "scene_node.h"
+#include "entity_store.h"
+#include "tick_context.h"
+#include "random.h"
 
 #define GRAVITY glm::vec3(0.0f, -1.0f, 0.0f)
 
@@ -12,8 +15,12 @@ namespace game {
 
 	// class EntityNode
 	// A node with some movement behaviour
+	// Its position, velocity, behaviour state and timers live in the EntityStore - the node is a view over its slot
 	class EntityNode : public SceneNode {
 
+		friend class EntityStore;
+		friend class TimerQueue;
+
 	public:
 		// Create scene node from given resources
 		EntityNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture = NULL);
@@ -23,24 +30,66 @@ namespace game {
 
 		virtual void update(double deltaTime);
 
+		// Behaviour for one tick, run in parallel across entities during SceneGraph::update
+		// Must only change this entity's own state; anything else goes through the CommandBuffer
+		virtual void think(const TickContext& ctx);
+
+		// Called on the main thread, before think, when a wake-up set with setTimer expires
+		virtual void onTimer(const TickContext& ctx);
+
 		void rise(glm::vec3 dir);
 
-		inline bool getIsGrounded() { return mIsGrounded; }
-		inline void setIsGrounded(bool b) { mIsGrounded = b; }
+		// Activation, see EntityStore. Main thread only
+		virtual bool isAsleep(void);
+		void wake();
+
+		// Transform overrides, the position is stored in the EntityStore
+		// These and the state accessors below are no-ops once the slot is released
+		virtual glm::vec3 getPosition(void);
+		virtual glm::vec3 getPreviousPosition(void);
+		virtual void setPosition(glm::vec3 position);
+		virtual void translate(glm::vec3 trans);
+
+		inline glm::vec3 getVelocity() { return mSlot < 0 ? glm::vec3(0.0f) : EntityStore::getVelocity(mSlot); }
+		inline void setVelocity(glm::vec3 v) { if (mSlot >= 0) EntityStore::setVelocity(mSlot, v); }
+		inline bool getIsGrounded() { return mSlot >= 0 && EntityStore::getIsGrounded(mSlot); }
+		inline void setIsGrounded(bool b) { if (mSlot >= 0) EntityStore::setIsGrounded(mSlot, b); }
+
+		// Give the slot back to the store once the node leaves the scene
+		void releaseSlot();
 
 	protected:
 
 		//PlayerNode* getPlayerNode();
 		//glm::vec3 getPlayerPosition();
 
-		// mPosition is stored in SceneNode
-		glm::vec3 mVelocity;
+		// Behaviour state and timers, interpreted by subclasses
+		inline int getBehaviourState() { return mSlot < 0 ? 0 : EntityStore::getBehaviour(mSlot); }
+		inline void setBehaviourState(int b) { if (mSlot >= 0) EntityStore::setBehaviour(mSlot, b); }
+		inline float getLastTimer() { return mSlot < 0 ? 0.0f : EntityStore::getLastTimer(mSlot); }
+		inline void setLastTimer(float t) { if (mSlot >= 0) EntityStore::setLastTimer(mSlot, t); }
+		inline float getNextTimer() { return mSlot < 0 ? 0.0f : EntityStore::getNextTimer(mSlot); }
+		inline void setNextTimer(float t) { if (mSlot >= 0) EntityStore::setNextTimer(mSlot, t); }
+
+		// Event-driven behaviour, main thread only (use the CommandBuffer from think)
+		// setTimer replaces any pending wake-up, setThinking controls whether think runs every tick
+		void setTimer(double delay);
+		void cancelTimer();
+		inline void setThinking(bool thinking) { if (mSlot >= 0) EntityStore::setThinking(mSlot, thinking); }
+
 		glm::vec3 mAcceleration;
 
-		bool mIsGrounded;
+		// Behaviour randomness, owned by this entity so think() never shares generator state between threads
+		Random mRandom;
+
+		// Index of this entity in the EntityStore, -1 once released
+		int mSlot;
+
+		// Bumped on every setTimer/cancelTimer, older entries in the TimerQueue are ignored
+		unsigned int mTimerGeneration;
 
 	private:
-		virtual void hitGround();
+		virtual void hitGround(const TickContext& ctx);
 
 
 
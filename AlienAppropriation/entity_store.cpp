@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <limits>
+
+#include "entity_store.h"
+#include "kinematics.h"
+#include "entity_node.h"
+
+namespace game {
+
+std::vector<float> EntityStore::mPosX, EntityStore::mPosY, EntityStore::mPosZ;
+std::vector<float> EntityStore::mPrevX, EntityStore::mPrevY, EntityStore::mPrevZ;
+std::vector<float> EntityStore::mVelX, EntityStore::mVelY, EntityStore::mVelZ;
+std::vector<int> EntityStore::mGrounded;
+std::vector<int> EntityStore::mBehaviour;
+std::vector<float> EntityStore::mLastTimer;
+std::vector<float> EntityStore::mNextTimer;
+std::vector<EntityNode*> EntityStore::mOwner;
+std::vector<int> EntityStore::mWantsThink;
+std::vector<int> EntityStore::mThinkList;
+std::vector<int> EntityStore::mThinkIndex;
+int EntityStore::mAwakeCount = 0;
+std::vector<int> EntityStore::mLanded;
+float EntityStore::mMinBound = -std::numeric_limits<float>::max();
+float EntityStore::mMaxBound = std::numeric_limits<float>::max();
+
+
+int EntityStore::allocate(EntityNode* owner)
+{
+	mPosX.push_back(0.0f); mPosY.push_back(0.0f); mPosZ.push_back(0.0f);
+	mPrevX.push_back(0.0f); mPrevY.push_back(0.0f); mPrevZ.push_back(0.0f);
+	mVelX.push_back(0.0f); mVelY.push_back(0.0f); mVelZ.push_back(0.0f);
+	mGrounded.push_back(1);
+	mBehaviour.push_back(0);
+	mLastTimer.push_back(0.0f);
+	mNextTimer.push_back(0.0f);
+	mOwner.push_back(owner);
+	mWantsThink.push_back(0);
+	mThinkIndex.push_back(-1);
+
+	// New entities start awake, so move ahead of the sleeping ones
+	swapSlots((int)mOwner.size() - 1, mAwakeCount);
+	return mAwakeCount++;
+}
+
+void EntityStore::release(int slot)
+{
+	removeThinker(slot);
+
+	// Leave the awake range first, then move the last entity into the freed slot so the arrays stay dense
+	if (!isAsleep(slot)) {
+		swapSlots(slot, mAwakeCount - 1);
+		slot = --mAwakeCount;
+	}
+	swapSlots(slot, (int)mOwner.size() - 1);
+
+	mPosX.pop_back(); mPosY.pop_back(); mPosZ.pop_back();
+	mPrevX.pop_back(); mPrevY.pop_back(); mPrevZ.pop_back();
+	mVelX.pop_back(); mVelY.pop_back(); mVelZ.pop_back();
+	mGrounded.pop_back();
+	mBehaviour.pop_back();
+	mLastTimer.pop_back();
+	mNextTimer.pop_back();
+	mOwner.pop_back();
+	mWantsThink.pop_back();
+	mThinkIndex.pop_back();
+}
+
+void EntityStore::swapSlots(int a, int b)
+{
+	if (a == b)
+		return;
+
+	std::swap(mPosX[a], mPosX[b]); std::swap(mPosY[a], mPosY[b]); std::swap(mPosZ[a], mPosZ[b]);
+	std::swap(mPrevX[a], mPrevX[b]); std::swap(mPrevY[a], mPrevY[b]); std::swap(mPrevZ[a], mPrevZ[b]);
+	std::swap(mVelX[a], mVelX[b]); std::swap(mVelY[a], mVelY[b]); std::swap(mVelZ[a], mVelZ[b]);
+	std::swap(mGrounded[a], mGrounded[b]);
+	std::swap(mBehaviour[a], mBehaviour[b]);
+	std::swap(mLastTimer[a], mLastTimer[b]);
+	std::swap(mNextTimer[a], mNextTimer[b]);
+	std::swap(mOwner[a], mOwner[b]);
+	std::swap(mWantsThink[a], mWantsThink[b]);
+	std::swap(mThinkIndex[a], mThinkIndex[b]);
+
+	mOwner[a]->mSlot = a;
+	mOwner[b]->mSlot = b;
+	if (mThinkIndex[a] >= 0) mThinkList[mThinkIndex[a]] = a;
+	if (mThinkIndex[b] >= 0) mThinkList[mThinkIndex[b]] = b;
+}
+
+void EntityStore::sleep(int slot)
+{
+	if (isAsleep(slot))
+		return;
+
+	removeThinker(slot);
+	swapSlots(slot, mAwakeCount - 1);
+	mAwakeCount--;
+}
+
+void EntityStore::wake(int slot)
+{
+	if (!isAsleep(slot))
+		return;
+
+	swapSlots(slot, mAwakeCount);
+	slot = mAwakeCount++;
+	if (mWantsThink[slot])
+		addThinker(slot);
+}
+
+void EntityStore::sleepIdle(glm::vec3 center, float radius)
+{
+	float radius2 = radius * radius;
+
+	// Backwards, so the entity swapped into a slot we put to sleep has already been looked at
+	for (int slot = mAwakeCount - 1; slot >= 0; slot--)
+	{
+		if (!mGrounded[slot] || mVelX[slot] != 0.0f || mVelY[slot] != 0.0f || mVelZ[slot] != 0.0f)
+			continue;
+
+		float dx = mPosX[slot] - center.x;
+		float dz = mPosZ[slot] - center.z;
+		if (dx * dx + dz * dz > radius2)
+			sleep(slot);
+	}
+}
+
+void EntityStore::setThinking(int slot, bool thinking)
+{
+	mWantsThink[slot] = thinking ? 1 : 0;
+	if (thinking && !isAsleep(slot))
+		addThinker(slot);
+	else
+		removeThinker(slot);
+}
+
+void EntityStore::addThinker(int slot)
+{
+	if (mThinkIndex[slot] >= 0)
+		return;
+
+	mThinkIndex[slot] = (int)mThinkList.size();
+	mThinkList.push_back(slot);
+}
+
+void EntityStore::removeThinker(int slot)
+{
+	int index = mThinkIndex[slot];
+	if (index < 0)
+		return;
+
+	// Swap-remove, the order of the list does not matter
+	int moved = mThinkList.back();
+	mThinkList[index] = moved;
+	mThinkIndex[moved] = index;
+	mThinkList.pop_back();
+	mThinkIndex[slot] = -1;
+}
+
+void EntityStore::integrate(const TickContext& ctx)
+{
+	mLanded.clear();
+
+	// Where everyone starts this tick, for the swept collision tests
+	std::copy(mPosX.begin(), mPosX.begin() + mAwakeCount, mPrevX.begin());
+	std::copy(mPosY.begin(), mPosY.begin() + mAwakeCount, mPrevY.begin());
+	std::copy(mPosZ.begin(), mPosZ.begin() + mAwakeCount, mPrevZ.begin());
+
+	KinematicsBatch batch;
+	batch.posX = mPosX.data(); batch.posY = mPosY.data(); batch.posZ = mPosZ.data();
+	batch.velX = mVelX.data(); batch.velY = mVelY.data(); batch.velZ = mVelZ.data();
+	batch.grounded = mGrounded.data();
+	batch.count = mAwakeCount;
+	batch.gravity = GRAVITY.y;
+	batch.minBound = mMinBound;
+	batch.maxBound = mMaxBound;
+
+	IntegrateKinematics(batch, mLanded);
+
+	// Landing callbacks run after the loop, since they may change the entity's state
+	// They can also wake other entities and move slots around, so resolve the owners first
+	std::vector<EntityNode*> landed;
+	for (int slot : mLanded)
+		landed.push_back(mOwner[slot]);
+
+	for (EntityNode* owner : landed)
+	{
+		owner->hitGround(ctx);
+	}
+}
+
+} // namespace game
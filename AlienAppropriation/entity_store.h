@@ -0,0 +1,113 @@
+#ifndef ENTITY_STORE_H_
+#define ENTITY_STORE_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "tick_context.h"
+
+namespace game {
+
+	class EntityNode;
+
+	// class EntityStore
+	// Structure-of-arrays storage for the simulation state of every EntityNode
+	// Nodes only keep a slot index into these arrays, so movement and gravity run as one
+	// tight loop over contiguous memory instead of through the node hierarchy.
+	// Slots are kept densely packed: releasing a slot moves the last entity into the hole.
+	// Awake entities occupy [0, getAwakeCount()), sleeping ones the rest, so per-tick passes
+	// only ever cover the awake range and a sleeping entity costs nothing until it is woken.
+	class EntityStore {
+
+	public:
+		// Slot management
+		static int allocate(EntityNode* owner);
+		static void release(int slot);
+
+		// Apply gravity, ground contact, velocity and the bounds clamp to every awake entity
+		static void integrate(const TickContext& ctx);
+
+		// Limits entity positions are clamped to on every axis, unbounded by default since the world is streamed
+		inline static void setBounds(float minBound, float maxBound) { mMinBound = minBound; mMaxBound = maxBound; }
+
+		inline static int getCount() { return (int)mOwner.size(); }
+		inline static int getAwakeCount() { return mAwakeCount; }
+		inline static EntityNode* getOwner(int slot) { return mOwner[slot]; }
+
+		// Activation, main thread only. Sleeping and waking move the entity to another slot
+		inline static bool isAsleep(int slot) { return slot >= mAwakeCount; }
+		static void sleep(int slot);
+		static void wake(int slot);
+		// Put to sleep every awake entity that is grounded, not moving and further than 'radius' from 'center' (in x/z)
+		static void sleepIdle(glm::vec3 center, float radius);
+
+		// Entities that need to think every tick, the rest only react to timers and events
+		// Sleeping entities keep the flag but leave the list until they wake
+		// Main thread only, the list is read during the parallel phase
+		static void setThinking(int slot, bool thinking);
+		inline static bool getThinking(int slot) { return mWantsThink[slot] != 0; }
+		inline static int getThinkCount() { return (int)mThinkList.size(); }
+		inline static EntityNode* getThinker(int i) { return mOwner[mThinkList[i]]; }
+
+		// Kinematics
+		inline static glm::vec3 getPosition(int slot) { return glm::vec3(mPosX[slot], mPosY[slot], mPosZ[slot]); }
+		inline static glm::vec3 getVelocity(int slot) { return glm::vec3(mVelX[slot], mVelY[slot], mVelZ[slot]); }
+		// Setting the position is a teleport: the entity doesn't sweep through the space in between
+		inline static void setPosition(int slot, glm::vec3 p)
+		{
+			mPosX[slot] = mPrevX[slot] = p.x;
+			mPosY[slot] = mPrevY[slot] = p.y;
+			mPosZ[slot] = mPrevZ[slot] = p.z;
+		}
+		// Position before the last integrate, the start of the path swept this tick
+		inline static glm::vec3 getPreviousPosition(int slot) { return glm::vec3(mPrevX[slot], mPrevY[slot], mPrevZ[slot]); }
+		inline static void setVelocity(int slot, glm::vec3 v) { mVelX[slot] = v.x; mVelY[slot] = v.y; mVelZ[slot] = v.z; }
+		inline static bool getIsGrounded(int slot) { return mGrounded[slot] != 0; }
+		inline static void setIsGrounded(int slot, bool b) { mGrounded[slot] = b ? 1 : 0; }
+
+		// Behaviour state and timers
+		inline static int getBehaviour(int slot) { return mBehaviour[slot]; }
+		inline static void setBehaviour(int slot, int b) { mBehaviour[slot] = b; }
+		inline static float getLastTimer(int slot) { return mLastTimer[slot]; }
+		inline static void setLastTimer(int slot, float t) { mLastTimer[slot] = t; }
+		inline static float getNextTimer(int slot) { return mNextTimer[slot]; }
+		inline static void setNextTimer(int slot, float t) { mNextTimer[slot] = t; }
+
+	private:
+		// Position and velocity, one array per component
+		static std::vector<float> mPosX, mPosY, mPosZ;
+		static std::vector<float> mVelX, mVelY, mVelZ;
+		static std::vector<float> mPrevX, mPrevY, mPrevZ;
+		static std::vector<int> mGrounded;
+
+		// Behaviour state (meaning is up to the owning node) and timers
+		static std::vector<int> mBehaviour;
+		static std::vector<float> mLastTimer;
+		static std::vector<float> mNextTimer;
+
+		// Node viewing each slot
+		static std::vector<EntityNode*> mOwner;
+
+		// Slots that think every tick, and each slot's index in that list (-1 if not in it)
+		static std::vector<int> mWantsThink;
+		static std::vector<int> mThinkList;
+		static std::vector<int> mThinkIndex;
+
+		// Number of awake entities, they come first in every array
+		static int mAwakeCount;
+
+		// Slots that touched the ground during the last integrate
+		static std::vector<int> mLanded;
+
+		static float mMinBound, mMaxBound;
+
+		// Exchange everything stored in two slots and fix up the owners and the think list
+		static void swapSlots(int a, int b);
+		static void addThinker(int slot);
+		static void removeThinker(int slot);
+
+	}; // class EntityStore
+
+} // namespace game
+
+#endif // ENTITY_STORE_H_
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <time.h>
 #include <sstream>
+#include <thread>
 
 #include "game.h"
 #include "bin/path_config.h"
@@ -30,6 +31,29 @@ glm::vec3 camera_up_g(0.0, 1.0, 0.0);
 const std::string shader_directory = SHADER_DIRECTORY;
 const std::string asset_directory = ASSET_DIRECTORY;
 
+// Particle materials come in two flavours: the geometry shader expands each point into a quad,
+// or the vertex shader sizes it as a point sprite ("Sprite" materials). Sprites skip the geometry stage,
+// which is slow on many drivers and on software rasterizers. Both are loaded, each material picks its own.
+// bench_particles compares the two
+struct ParticlePath {
+	std::string material;
+	bool sprites;
+};
+ParticlePath particle_paths_g[] = {
+	{ "particleBeam", true },
+	{ "particleShield", true },
+	{ "particleSystem", true },
+};
+
+static std::string ParticleMaterial(const std::string name)
+{
+	for (const ParticlePath& path : particle_paths_g) {
+		if (path.material == name)
+			return name + (path.sprites ? "Sprite" : "") + "Material";
+	}
+	return name + "Material";
+}
+
 
 Game::Game(void)
 {
@@ -44,15 +68,14 @@ void Game::Init(void)
 	mCamera = new Camera("camera");
 	// Set up the base nodes
 	mSceneGraph = new SceneGraph(mCamera);
-	mMapGenerator = new MapGenerator(mSceneGraph);
 
     // Run all initialization steps
     InitWindow();
     InitView();
     InitEventHandlers();
 
-	srand(time(0));
-	rand();
+	mWorldSeed = (uint32_t)time(0);
+	Random::setGlobalSeed(mWorldSeed);
 }
 
 
@@ -84,6 +107,9 @@ void Game::InitWindow(void){
     if (err != GLEW_OK){
         throw(GameException(std::string("Could not initialize the GLEW library: ")+std::string((const char *) glewGetErrorString(err))));
     }
+
+    // Buffers behind the uniform blocks every material shares
+    UniformBuffers::Init();
 }
 
 
@@ -93,6 +119,9 @@ void Game::InitView(void){
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
 
+    // Point sprites take their size from the vertex shader
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
 
 
 
@@ -122,8 +151,6 @@ void Game::InitEventHandlers(void){
 
 void Game::SetupResources(void){
 
-	// Create a plane
-	mResourceManager->CreateGrid("GridMesh");
 	// Create a cube for the skybox
 	mResourceManager->CreateCube("cubeMesh");
 	mResourceManager->CreateCylinder("hayMesh");
@@ -134,7 +161,8 @@ void Game::SetupResources(void){
 	mResourceManager->CreateCylinder("energyMesh", 0.6f, 30, glm::vec3(0.0f, 0.7f, 0.7f));
 
 	std::string filename;
-	std::string materials[] = { "default", "textured", "litTexture", "skybox", "particleBeam", "particleShield" };
+	std::string materials[] = { "default", "textured", "litTexture", "skybox", "particleBeam", "particleShield", "particleSystem",
+		"particleBeamSprite", "particleShieldSprite", "particleSystemSprite" };
 	for (std::string name : materials) {
 		filename = std::string(shader_directory) + std::string("/" + name);
 		mResourceManager->LoadResource(Material, name + "Material", filename.c_str());
@@ -157,12 +185,20 @@ void Game::SetupResources(void){
 		mResourceManager->LoadResource(Texture, name + "Texture", filename.c_str());
 	}
 
+	// Simulation step of the GPU particles, its outputs in the order they are laid out in the particle buffers
+	filename = std::string(shader_directory) + std::string("/particleUpdate");
+	mResourceManager->LoadFeedbackProgram("particleUpdateProgram", filename.c_str(), { "out_position", "out_velocity", "out_color", "out_life" });
+
 	std::string skyboxes[] = { "Day1" };
 	for (std::string name : skyboxes) {
 		// Load texture to be applied to the cube
 		filename = std::string(asset_directory) + std::string("/skyboxes/" + name + "/" +name +".png");
 		mResourceManager->LoadResource(CubeMap, name + "CubeMap", filename.c_str());
 	}
+
+	// What the map generator can place, needs the meshes and textures above
+	filename = std::string(asset_directory) + std::string("/objects.cfg");
+	mCatalogue.Load(filename.c_str());
 }
 
 
@@ -171,31 +207,13 @@ void Game::SetupScene(void){
     // Set background color for the scene
     mSceneGraph->SetBackgroundColor(viewport_background_color_g);
 
-	for (int i = 0; i < 40; i++)
-	{
-		CowEntityNode* cow = mSceneGraph->CreateInstance<CowEntityNode>("Cow" + std::to_string(i), "cowMesh", "texturedMaterial", "cowTexture");
-		cow->translate(glm::vec3((rand() % 300), 0.0, (rand() % 300)));
-	}
-
-	for (int i = 0; i < 20; i++)
-	{
-		BullEntityNode* bull = mSceneGraph->CreateInstance<BullEntityNode>("Bull" + std::to_string(i), "cowMesh", "texturedMaterial", "bullTexture");
-		bull->translate(glm::vec3((rand() % 300), 0.0, (rand() % 300)));
-	}
-
-	for (int i = 0; i < 20; i++)
-	{
-		FarmerEntityNode* farmer = mSceneGraph->CreateInstance<FarmerEntityNode>("Farmer" + std::to_string(i), "farmerMesh", "texturedMaterial", "farmerTexture");
-		farmer->scale(glm::vec3(0.75, 1.5, 0.75));
-		farmer->translate(glm::vec3((rand() % 300), 0.0, (rand() % 300)));
-	}
+	// Ground, built in chunks around the camera as it moves
+	mTerrain = new Terrain("terrain", mCamera, mResourceManager->getResource("litTextureMaterial"), mResourceManager->getResource("groundTexture"), mWorldSeed);
+	mSceneGraph->addNode(mTerrain);
 
-	for (int i = 0; i < 5; i++)
-	{
-		CannonMissileEntityNode* cannon = mSceneGraph->CreateInstance<CannonMissileEntityNode>("Cannon" + std::to_string(i), "cannonMesh", "litTextureMaterial", "cannonTexture");
-		cannon->scale(glm::vec3(2.0, 2.0, 2.0));
-		cannon->translate(glm::vec3((rand() % 300), 0.0, (rand() % 300)));
-	}
+	// Debris, trails and other effects simulated on the GPU
+	ParticleSystem* particles = new ParticleSystem("particles", mResourceManager->getResource("particleUpdateProgram"), mResourceManager->getResource(ParticleMaterial("particleSystem")));
+	mSceneGraph->addNode(particles);
 
 	// stats for the player and ui nodes to hold
 	float* max_stat = new float(100);
@@ -208,7 +226,7 @@ void Game::SetupScene(void){
 	player->setEnvMap(mResourceManager->getResource("Day1CubeMap"));
 
 	//Create tractor beam
-	SceneNode* weapon = mSceneGraph->CreateInstance<SceneNode>("TRACTORBEAM", "coneParticles", "particleBeamMaterial");
+	SceneNode* weapon = mSceneGraph->CreateInstance<SceneNode>("TRACTORBEAM", "coneParticles", ParticleMaterial("particleBeam"));
 	mSceneGraph->getRootNode()->removeChildNode("TRACTORBEAM");
 	player->addWeapon(weapon);
 	weapon->translate(glm::vec3(0.0, 0.0, 0.0));
@@ -218,13 +236,14 @@ void Game::SetupScene(void){
 
 
 	//Create shields
-	weapon = mSceneGraph->CreateInstance<SceneNode>("SHIELD", "shieldParticles", "particleShieldMaterial");
+	weapon = mSceneGraph->CreateInstance<SceneNode>("SHIELD", "shieldParticles", ParticleMaterial("particleShield"));
 	mSceneGraph->getRootNode()->removeChildNode("SHIELD");
 	player->addWeapon(weapon);
 	weapon->translate(glm::vec3(0.0, 0.0, 0.0));
 	weapon->scale(glm::vec3(10.0, 10.0, 10.0));
 
-	mMapGenerator->GenerateMap();
+	// Fields, animals and enemies are generated in the background and stream in around the camera from the first frame
+	mMapGenerator = new MapGenerator(mSceneGraph, &mCatalogue, mWorldSeed);
 
 
 	//Create UI elements
@@ -246,17 +265,30 @@ void Game::MainLoop(void){
 
     // Loop while the user did not close the window
     while (!glfwWindowShouldClose(mWindow)){
-        // Animate the scene
+        // Read the clock once, everything this frame uses the same time
+        mClock.sample();
+        mCamera->setFrameTime(mClock.getTime());
+
+        // Animate the scene, ticks follow game time so they stop while paused
         static double last_time = 0;
-        double current_time = glfwGetTime();
+        double current_time = mClock.getTime();
 		double deltaTime = current_time - last_time;
         if ((current_time - last_time) > 0.05){
-            bool dead = mSceneGraph->update(deltaTime);
+            mMapGenerator->update(mCamera->getPosition());
+            bool dead = mSceneGraph->update(deltaTime, current_time);
             last_time = current_time;
 			skybox_->setPosition(mCamera->getPosition());
 			if (dead) break;
         }
 
+        // Show stats in the window title once a second (of real time, so it still refreshes while paused)
+        static double last_stats_time = 0;
+        double real_time = mClock.getRealTime();
+        if ((real_time - last_stats_time) > 1.0){
+            UpdateStatsTitle();
+            last_stats_time = real_time;
+        }
+
         // draw the scene
         mSceneGraph->draw(mCamera);
 
@@ -347,7 +379,44 @@ void Game::KeyCallback(GLFWwindow* window, int key, int scancode, int action, in
 	if (key == GLFW_KEY_R) {
 		playerNode->dropBomb();
 	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		// Cycle the number of update threads, to compare scaling from 1 to N cores
+		JobSystem* jobs = game->mSceneGraph->getJobSystem();
+		int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+		jobs->setThreadCount(jobs->getThreadCount() % maxThreads + 1);
+	}
+	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+		game->mClock.togglePaused();
+	}
+	if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS) {
+		game->mClock.setTimeScale(game->mClock.getTimeScale() * 0.5);
+	}
+	if (key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_PRESS) {
+		game->mClock.setTimeScale(game->mClock.getTimeScale() * 2.0);
+	}
+
+}
+
 
+void Game::UpdateStatsTitle(void){
+
+	const Stats& stats = SceneGraph::getStats();
+	std::ostringstream title;
+	title.precision(2);
+	title << std::fixed << window_title_g
+		<< " | " << stats.threads << " threads"
+		<< " | update " << stats.updateMs << " ms (think " << stats.thinkMs << " ms)"
+		<< " | " << stats.entities << " entities (" << stats.awake << " awake, " << stats.asleep << " asleep, "
+		<< stats.thinking << " thinking, " << stats.timers << " timers)"
+		<< " | " << stats.projectiles << " projectiles"
+		<< " | " << stats.nodes << " nodes (" << stats.nodeKb << " KB)"
+		<< " | " << stats.triangles << " tris"
+		<< " | " << stats.particles << " particles spawned"
+		<< " | " << stats.pairs << " pairs"
+		<< " | time x" << mClock.getTimeScale();
+	if (mClock.isPaused())
+		title << " (paused)";
+	glfwSetWindowTitle(mWindow, title.str().c_str());
 }
 
 
@@ -363,6 +432,9 @@ void Game::ResizeCallback(GLFWwindow* window, int width, int height){
 
 Game::~Game(){
 
+	// Stops the generation thread
+	delete mMapGenerator;
+	UniformBuffers::Destroy();
     glfwTerminate();
 }
 
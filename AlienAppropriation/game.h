@@ -15,6 +15,9 @@
 #include "player_node.h"
 #include "ui_node.h"
 #include "map_generator.h"
+#include "terrain.h"
+#include "particle_system.h"
+#include "game_clock.h"
 
 namespace game {
     // Game application
@@ -45,9 +48,21 @@ namespace game {
 
 			MapGenerator* mMapGenerator;
 
+			// Kinds of objects placed by the map generator
+			ObjectCatalogue mCatalogue;
+
+			// Ground around the camera
+			Terrain* mTerrain;
+
+			// Seed everything procedural in the world is derived from
+			uint32_t mWorldSeed;
+
             // Camera abstraction
             Camera* mCamera;
 
+            // Game time, sampled once per frame
+            GameClock mClock;
+
 			SceneNode *skybox_;
 
             // Methods to initialize the game
@@ -55,6 +70,9 @@ namespace game {
             void InitView(void);
             void InitEventHandlers(void);
 
+            // Show the scene graph stats in the window title
+            void UpdateStatsTitle(void);
+
             // Methods to handle events
             static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
             static void ResizeCallback(GLFWwindow* window, int width, int height);
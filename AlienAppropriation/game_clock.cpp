@@ -0,0 +1,34 @@
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "game_clock.h"
+
+namespace game {
+
+GameClock::GameClock(void)
+	: mRealTime(0.0)
+	, mGameTime(0.0)
+	, mDelta(0.0)
+	, mTimeScale(1.0)
+	, mPaused(false)
+{
+}
+
+void GameClock::sample(void)
+{
+	double realTime = glfwGetTime();
+	double realDelta = realTime - mRealTime;
+	mRealTime = realTime;
+
+	mDelta = mPaused ? 0.0 : realDelta * mTimeScale;
+	mGameTime += mDelta;
+}
+
+void GameClock::setTimeScale(double scale)
+{
+	mTimeScale = glm::clamp(scale, 0.0625, 8.0);
+}
+
+} // namespace game
@@ -0,0 +1,43 @@
+#ifndef GAME_CLOCK_H_
+#define GAME_CLOCK_H_
+
+namespace game {
+
+	// class GameClock
+	// The one place the game reads the system clock - sampled once per frame
+	// Everything else gets "now" from here (through the TickContext or the camera), so all
+	// entities in a tick see the same time. Game time can be paused and scaled.
+	class GameClock {
+
+	public:
+		GameClock(void);
+
+		// Read the system clock and advance game time, call once per frame
+		void sample(void);
+
+		// Scaled game time in seconds, frozen while paused
+		inline double getTime(void) const { return mGameTime; }
+		// Game time that passed between the last two samples
+		inline double getDelta(void) const { return mDelta; }
+		// Unscaled system time at the last sample
+		inline double getRealTime(void) const { return mRealTime; }
+
+		// Pause and time scaling
+		inline bool isPaused(void) const { return mPaused; }
+		inline void setPaused(bool paused) { mPaused = paused; }
+		inline void togglePaused(void) { mPaused = !mPaused; }
+		inline double getTimeScale(void) const { return mTimeScale; }
+		void setTimeScale(double scale);
+
+	private:
+		double mRealTime;	// System time at the last sample
+		double mGameTime;
+		double mDelta;
+		double mTimeScale;
+		bool mPaused;
+
+	}; // class GameClock
+
+} // namespace game
+
+#endif // GAME_CLOCK_H_
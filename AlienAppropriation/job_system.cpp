@@ -0,0 +1,167 @@
+#include <algorithm>
+
+#include "job_system.h"
+#include "command_buffer.h"
+
+namespace game {
+
+// Index of the thread running the current code, workers set theirs when they start
+static thread_local int sThreadIndex = 0;
+
+
+JobSystem::JobSystem(int threadCount)
+	: mPending(0)
+	, mQueued(0)
+	, mRunning(false)
+{
+	start(threadCount);
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+int JobSystem::getThreadIndex()
+{
+	return sThreadIndex;
+}
+
+void JobSystem::setThreadCount(int threadCount)
+{
+	stop();
+	start(threadCount);
+}
+
+void JobSystem::start(int threadCount)
+{
+	if (threadCount < 1)
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+	mQueues.clear();
+	for (int i = 0; i < threadCount; i++)
+		mQueues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+	// Every thread records its commands separately
+	CommandBuffer::setThreadCount(threadCount);
+
+	mRunning = true;
+	for (int i = 1; i < threadCount; i++)
+		mThreads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mRunning = false;
+	}
+	mWake.notify_all();
+
+	for (std::thread& t : mThreads)
+		t.join();
+	mThreads.clear();
+}
+
+bool JobSystem::popOrSteal(int index, Job& job)
+{
+	// Own queue first, newest job (most likely still in cache)
+	{
+		Queue& own = *mQueues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = own.jobs.back();
+			own.jobs.pop_back();
+			mQueued--;
+			return true;
+		}
+	}
+
+	// Then steal the oldest job from someone else
+	int count = (int)mQueues.size();
+	for (int i = 1; i < count; i++) {
+		Queue& other = *mQueues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.jobs.empty()) {
+			job = other.jobs.front();
+			other.jobs.pop_front();
+			mQueued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::workerLoop(int index)
+{
+	sThreadIndex = index;
+
+	while (true)
+	{
+		Job job;
+		if (popOrSteal(index, job)) {
+			(*job.fn)(job.begin, job.end);
+			mPending--;
+			continue;
+		}
+
+		// Sleep until there is something to take, not just until the batch is done:
+		// the last chunks still running elsewhere are no reason to wake up
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait(lock, [this] { return !mRunning || mQueued > 0; });
+		if (!mRunning)
+			return;
+	}
+}
+
+void JobSystem::parallelFor(int count, int grain, const std::function<void(int, int)>& fn)
+{
+	if (count <= 0)
+		return;
+
+	// Nothing to gain from the pool
+	int threadCount = (int)mQueues.size();
+	if (threadCount == 1 || count <= grain) {
+		fn(0, count);
+		return;
+	}
+
+	// Count the chunks before publishing any, so mPending never drops to zero early
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mPending += (count + grain - 1) / grain;
+	}
+
+	// Deal the chunks out round-robin so every thread starts with local work
+	int chunk = 0;
+	for (int begin = 0; begin < count; begin += grain, chunk++) {
+		Job job = { &fn, begin, std::min(begin + grain, count) };
+		Queue& q = *mQueues[chunk % threadCount];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		q.jobs.push_back(job);
+	}
+
+	// Published under the wake mutex so a worker going to sleep either sees the new jobs or gets the notify
+	// Workers still busy may already have taken some, mQueued only has to be right once it is added
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQueued += chunk;
+	}
+	mWake.notify_all();
+
+	// The main thread works too, then waits for stragglers
+	while (mPending > 0)
+	{
+		Job job;
+		if (popOrSteal(0, job)) {
+			(*job.fn)(job.begin, job.end);
+			mPending--;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+} // namespace game
@@ -0,0 +1,68 @@
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace game {
+
+	// class JobSystem
+	// A small pool of worker threads with one job queue per thread
+	// Threads take work from the back of their own queue and steal from the front of the others' when they run dry
+	// The calling (main) thread is thread 0 and helps out until a parallelFor is complete
+	class JobSystem {
+
+	public:
+		// threadCount includes the main thread, values < 1 use every hardware thread
+		JobSystem(int threadCount = 0);
+		~JobSystem();
+
+		// Split [0, count) into chunks of at most 'grain' items and run fn(begin, end) on each, in parallel
+		// Returns once every chunk has been processed
+		void parallelFor(int count, int grain, const std::function<void(int, int)>& fn);
+
+		// Restart the pool with a different number of threads (used to measure scaling)
+		void setThreadCount(int threadCount);
+		inline int getThreadCount() { return (int)mQueues.size(); }
+
+		// Index of the calling thread: 0 for the main thread, 1..N-1 for workers
+		static int getThreadIndex();
+
+	private:
+		struct Job {
+			const std::function<void(int, int)>* fn;
+			int begin;
+			int end;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::thread> mThreads;
+		std::vector<std::unique_ptr<Queue>> mQueues;
+
+		std::atomic<int> mPending;	// Jobs pushed but not yet finished
+		std::atomic<int> mQueued;	// Jobs sitting in a queue, not yet taken by any thread
+		std::atomic<bool> mRunning;
+
+		std::mutex mWakeMutex;
+		std::condition_variable mWake;
+
+		void start(int threadCount);
+		void stop();
+		void workerLoop(int index);
+		bool popOrSteal(int index, Job& job);
+
+	}; // class JobSystem
+
+} // namespace game
+
+#endif // JOB_SYSTEM_H_
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KINEMATICS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KINEMATICS_SSE2 1
+#endif
+
+#include "kinematics.h"
+
+namespace game {
+
+void IntegrateKinematicsScalar(KinematicsBatch& b, int begin, int end, std::vector<int>& landed)
+{
+	for (int i = begin; i < end; i++)
+	{
+		// Apply Gravity
+		if (!b.grounded[i])
+		{
+			if (b.posY[i] > 0.0f)
+			{
+				b.velY[i] += b.gravity;
+				b.velX[i] = 0.0f;
+				b.velZ[i] = 0.0f;
+			}
+			else
+			{
+				b.velY[i] = 0.0f;
+				b.posY[i] = 0.0f;
+				b.grounded[i] = 1;
+				landed.push_back(i);
+			}
+		}
+		else
+			b.velY[i] = std::max(b.velY[i], 0.0f);
+
+		// Move and clamp to the bounds
+		b.posX[i] = std::min(std::max(b.posX[i] + b.velX[i], b.minBound), b.maxBound);
+		b.posY[i] = std::min(std::max(b.posY[i] + b.velY[i], b.minBound), b.maxBound);
+		b.posZ[i] = std::min(std::max(b.posZ[i] + b.velZ[i], b.minBound), b.maxBound);
+	}
+}
+
+void SteerProjectilesScalar(SteeringBatch& b, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		float vx = b.velX[i], vy = b.velY[i], vz = b.velZ[i];
+
+		// Homing: turn towards the target and keep flying at full speed
+		if (b.maxSpeed[i] > 0.0f)
+		{
+			vx += b.turn * (b.targetX - b.posX[i]);
+			vy += b.turn * (b.targetY - b.posY[i]);
+			vz += b.turn * (b.targetZ - b.posZ[i]);
+			float length = std::sqrt(vx * vx + vy * vy + vz * vz);
+			float scale = length > 0.0f ? b.maxSpeed[i] / length : 0.0f;
+			vx *= scale; vy *= scale; vz *= scale;
+			b.velX[i] = vx; b.velY[i] = vy; b.velZ[i] = vz;
+		}
+
+		// Facing: yaw about y, then pitch about x, with the half angles straight from the direction's cosines
+		float speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+		if (speed <= 0.0f)
+			continue;
+		float dx = vx / speed, dy = vy / speed, dz = vz / speed;
+		float h = std::sqrt(dx * dx + dz * dz);
+		float cosYaw = h > 0.0f ? dz / h : 1.0f;
+		float cy = std::sqrt(std::max(0.5f * (1.0f + cosYaw), 0.0f));
+		float sy = std::copysign(std::sqrt(std::max(0.5f * (1.0f - cosYaw), 0.0f)), dx);
+		float cp = std::sqrt(0.5f * (1.0f + h));
+		float sp = std::copysign(std::sqrt(std::max(0.5f * (1.0f - h), 0.0f)), -dy);
+
+		b.orientW[i] = cy * cp;
+		b.orientX[i] = cy * sp;
+		b.orientY[i] = sy * cp;
+		b.orientZ[i] = -sy * sp;
+	}
+}
+
+#if KINEMATICS_AVX2
+
+void IntegrateKinematics(KinematicsBatch& b, std::vector<int>& landed)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 gravity = _mm256_set1_ps(b.gravity);
+	const __m256 lo = _mm256_set1_ps(b.minBound);
+	const __m256 hi = _mm256_set1_ps(b.maxBound);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	int i = 0;
+	for (; i + 8 <= b.count; i += 8)
+	{
+		__m256 px = _mm256_loadu_ps(b.posX + i), py = _mm256_loadu_ps(b.posY + i), pz = _mm256_loadu_ps(b.posZ + i);
+		__m256 vx = _mm256_loadu_ps(b.velX + i), vy = _mm256_loadu_ps(b.velY + i), vz = _mm256_loadu_ps(b.velZ + i);
+		__m256i g = _mm256_loadu_si256((const __m256i*)(b.grounded + i));
+
+		// Lane masks: airborne and above ground (falling), airborne and at/below ground (landing)
+		__m256 air = _mm256_castsi256_ps(_mm256_cmpeq_epi32(g, _mm256_setzero_si256()));
+		__m256 above = _mm256_cmp_ps(py, zero, _CMP_GT_OQ);
+		__m256 falling = _mm256_and_ps(air, above);
+		__m256 landing = _mm256_andnot_ps(above, air);
+
+		// Falling: add gravity and drop horizontal velocity
+		// Landing: snap to the ground and stop vertically
+		// Grounded: never move downwards
+		vy = _mm256_blendv_ps(_mm256_max_ps(vy, zero), _mm256_add_ps(vy, gravity), air);
+		vy = _mm256_andnot_ps(landing, vy);
+		vx = _mm256_andnot_ps(falling, vx);
+		vz = _mm256_andnot_ps(falling, vz);
+		py = _mm256_andnot_ps(landing, py);
+		g = _mm256_or_si256(g, _mm256_and_si256(_mm256_castps_si256(landing), one));
+
+		// Move and clamp to the bounds
+		px = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(px, vx), lo), hi);
+		py = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(py, vy), lo), hi);
+		pz = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(pz, vz), lo), hi);
+
+		_mm256_storeu_ps(b.posX + i, px); _mm256_storeu_ps(b.posY + i, py); _mm256_storeu_ps(b.posZ + i, pz);
+		_mm256_storeu_ps(b.velX + i, vx); _mm256_storeu_ps(b.velY + i, vy); _mm256_storeu_ps(b.velZ + i, vz);
+		_mm256_storeu_si256((__m256i*)(b.grounded + i), g);
+
+		int landedMask = _mm256_movemask_ps(landing);
+		for (int lane = 0; landedMask && lane < 8; lane++)
+		{
+			if (landedMask & (1 << lane)) landed.push_back(i + lane);
+		}
+	}
+
+	IntegrateKinematicsScalar(b, i, b.count, landed);
+}
+
+void SteerProjectiles(SteeringBatch& b)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 turn = _mm256_set1_ps(b.turn);
+	const __m256 tx = _mm256_set1_ps(b.targetX), ty = _mm256_set1_ps(b.targetY), tz = _mm256_set1_ps(b.targetZ);
+
+	int i = 0;
+	for (; i + 8 <= b.count; i += 8)
+	{
+		__m256 vx = _mm256_loadu_ps(b.velX + i), vy = _mm256_loadu_ps(b.velY + i), vz = _mm256_loadu_ps(b.velZ + i);
+		__m256 maxSpeed = _mm256_loadu_ps(b.maxSpeed + i);
+
+		// Homing lanes turn towards the target and are scaled back to full speed
+		__m256 homing = _mm256_cmp_ps(maxSpeed, zero, _CMP_GT_OQ);
+		__m256 hx = _mm256_add_ps(vx, _mm256_mul_ps(turn, _mm256_sub_ps(tx, _mm256_loadu_ps(b.posX + i))));
+		__m256 hy = _mm256_add_ps(vy, _mm256_mul_ps(turn, _mm256_sub_ps(ty, _mm256_loadu_ps(b.posY + i))));
+		__m256 hz = _mm256_add_ps(vz, _mm256_mul_ps(turn, _mm256_sub_ps(tz, _mm256_loadu_ps(b.posZ + i))));
+		__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hy, hy)), _mm256_mul_ps(hz, hz)));
+		__m256 scale = _mm256_and_ps(_mm256_cmp_ps(length, zero, _CMP_GT_OQ), _mm256_div_ps(maxSpeed, length));
+		vx = _mm256_blendv_ps(vx, _mm256_mul_ps(hx, scale), homing);
+		vy = _mm256_blendv_ps(vy, _mm256_mul_ps(hy, scale), homing);
+		vz = _mm256_blendv_ps(vz, _mm256_mul_ps(hz, scale), homing);
+		_mm256_storeu_ps(b.velX + i, vx); _mm256_storeu_ps(b.velY + i, vy); _mm256_storeu_ps(b.velZ + i, vz);
+
+		// Facing, lanes standing still keep the one they had
+		__m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+		__m256 moving = _mm256_cmp_ps(speed, zero, _CMP_GT_OQ);
+		__m256 inv = _mm256_div_ps(one, _mm256_blendv_ps(one, speed, moving));
+		__m256 dx = _mm256_mul_ps(vx, inv), dy = _mm256_mul_ps(vy, inv), dz = _mm256_mul_ps(vz, inv);
+		__m256 h = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)));
+		__m256 flat = _mm256_cmp_ps(h, zero, _CMP_GT_OQ);
+		__m256 cosYaw = _mm256_blendv_ps(one, _mm256_div_ps(dz, _mm256_blendv_ps(one, h, flat)), flat);
+		__m256 cy = _mm256_sqrt_ps(_mm256_max_ps(_mm256_mul_ps(half, _mm256_add_ps(one, cosYaw)), zero));
+		__m256 sy = _mm256_sqrt_ps(_mm256_max_ps(_mm256_mul_ps(half, _mm256_sub_ps(one, cosYaw)), zero));
+		sy = _mm256_or_ps(sy, _mm256_and_ps(sign, dx));
+		__m256 cp = _mm256_sqrt_ps(_mm256_mul_ps(half, _mm256_add_ps(one, h)));
+		__m256 sp = _mm256_sqrt_ps(_mm256_max_ps(_mm256_mul_ps(half, _mm256_sub_ps(one, h)), zero));
+		sp = _mm256_or_ps(sp, _mm256_andnot_ps(_mm256_and_ps(sign, dy), sign));
+
+		__m256 qw = _mm256_mul_ps(cy, cp), qx = _mm256_mul_ps(cy, sp), qy = _mm256_mul_ps(sy, cp), qz = _mm256_xor_ps(sign, _mm256_mul_ps(sy, sp));
+		_mm256_storeu_ps(b.orientW + i, _mm256_blendv_ps(_mm256_loadu_ps(b.orientW + i), qw, moving));
+		_mm256_storeu_ps(b.orientX + i, _mm256_blendv_ps(_mm256_loadu_ps(b.orientX + i), qx, moving));
+		_mm256_storeu_ps(b.orientY + i, _mm256_blendv_ps(_mm256_loadu_ps(b.orientY + i), qy, moving));
+		_mm256_storeu_ps(b.orientZ + i, _mm256_blendv_ps(_mm256_loadu_ps(b.orientZ + i), qz, moving));
+	}
+
+	SteerProjectilesScalar(b, i, b.count);
+}
+
+#elif KINEMATICS_SSE2
+
+void IntegrateKinematics(KinematicsBatch& b, std::vector<int>& landed)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 gravity = _mm_set1_ps(b.gravity);
+	const __m128 lo = _mm_set1_ps(b.minBound);
+	const __m128 hi = _mm_set1_ps(b.maxBound);
+	const __m128i one = _mm_set1_epi32(1);
+
+	int i = 0;
+	for (; i + 4 <= b.count; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(b.posX + i), py = _mm_loadu_ps(b.posY + i), pz = _mm_loadu_ps(b.posZ + i);
+		__m128 vx = _mm_loadu_ps(b.velX + i), vy = _mm_loadu_ps(b.velY + i), vz = _mm_loadu_ps(b.velZ + i);
+		__m128i g = _mm_loadu_si128((const __m128i*)(b.grounded + i));
+
+		// Lane masks: airborne and above ground (falling), airborne and at/below ground (landing)
+		__m128 air = _mm_castsi128_ps(_mm_cmpeq_epi32(g, _mm_setzero_si128()));
+		__m128 above = _mm_cmpgt_ps(py, zero);
+		__m128 falling = _mm_and_ps(air, above);
+		__m128 landing = _mm_andnot_ps(above, air);
+
+		// Falling: add gravity and drop horizontal velocity
+		// Landing: snap to the ground and stop vertically
+		// Grounded: never move downwards
+		vy = _mm_or_ps(_mm_and_ps(air, _mm_add_ps(vy, gravity)), _mm_andnot_ps(air, _mm_max_ps(vy, zero)));
+		vy = _mm_andnot_ps(landing, vy);
+		vx = _mm_andnot_ps(falling, vx);
+		vz = _mm_andnot_ps(falling, vz);
+		py = _mm_andnot_ps(landing, py);
+		g = _mm_or_si128(g, _mm_and_si128(_mm_castps_si128(landing), one));
+
+		// Move and clamp to the bounds
+		px = _mm_min_ps(_mm_max_ps(_mm_add_ps(px, vx), lo), hi);
+		py = _mm_min_ps(_mm_max_ps(_mm_add_ps(py, vy), lo), hi);
+		pz = _mm_min_ps(_mm_max_ps(_mm_add_ps(pz, vz), lo), hi);
+
+		_mm_storeu_ps(b.posX + i, px); _mm_storeu_ps(b.posY + i, py); _mm_storeu_ps(b.posZ + i, pz);
+		_mm_storeu_ps(b.velX + i, vx); _mm_storeu_ps(b.velY + i, vy); _mm_storeu_ps(b.velZ + i, vz);
+		_mm_storeu_si128((__m128i*)(b.grounded + i), g);
+
+		int landedMask = _mm_movemask_ps(landing);
+		for (int lane = 0; landedMask && lane < 4; lane++)
+		{
+			if (landedMask & (1 << lane)) landed.push_back(i + lane);
+		}
+	}
+
+	IntegrateKinematicsScalar(b, i, b.count, landed);
+}
+
+// SSE2 has no blend, pick 'a' where 'mask' is set and 'b' elsewhere
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void SteerProjectiles(SteeringBatch& b)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 turn = _mm_set1_ps(b.turn);
+	const __m128 tx = _mm_set1_ps(b.targetX), ty = _mm_set1_ps(b.targetY), tz = _mm_set1_ps(b.targetZ);
+
+	int i = 0;
+	for (; i + 4 <= b.count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(b.velX + i), vy = _mm_loadu_ps(b.velY + i), vz = _mm_loadu_ps(b.velZ + i);
+		__m128 maxSpeed = _mm_loadu_ps(b.maxSpeed + i);
+
+		// Homing lanes turn towards the target and are scaled back to full speed
+		__m128 homing = _mm_cmpgt_ps(maxSpeed, zero);
+		__m128 hx = _mm_add_ps(vx, _mm_mul_ps(turn, _mm_sub_ps(tx, _mm_loadu_ps(b.posX + i))));
+		__m128 hy = _mm_add_ps(vy, _mm_mul_ps(turn, _mm_sub_ps(ty, _mm_loadu_ps(b.posY + i))));
+		__m128 hz = _mm_add_ps(vz, _mm_mul_ps(turn, _mm_sub_ps(tz, _mm_loadu_ps(b.posZ + i))));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, hx), _mm_mul_ps(hy, hy)), _mm_mul_ps(hz, hz)));
+		__m128 scale = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(maxSpeed, length));
+		vx = Select(homing, _mm_mul_ps(hx, scale), vx);
+		vy = Select(homing, _mm_mul_ps(hy, scale), vy);
+		vz = Select(homing, _mm_mul_ps(hz, scale), vz);
+		_mm_storeu_ps(b.velX + i, vx); _mm_storeu_ps(b.velY + i, vy); _mm_storeu_ps(b.velZ + i, vz);
+
+		// Facing, lanes standing still keep the one they had
+		__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		__m128 moving = _mm_cmpgt_ps(speed, zero);
+		__m128 inv = _mm_div_ps(one, Select(moving, speed, one));
+		__m128 dx = _mm_mul_ps(vx, inv), dy = _mm_mul_ps(vy, inv), dz = _mm_mul_ps(vz, inv);
+		__m128 h = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+		__m128 flat = _mm_cmpgt_ps(h, zero);
+		__m128 cosYaw = Select(flat, _mm_div_ps(dz, Select(flat, h, one)), one);
+		__m128 cy = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(half, _mm_add_ps(one, cosYaw)), zero));
+		__m128 sy = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(half, _mm_sub_ps(one, cosYaw)), zero));
+		sy = _mm_or_ps(sy, _mm_and_ps(sign, dx));
+		__m128 cp = _mm_sqrt_ps(_mm_mul_ps(half, _mm_add_ps(one, h)));
+		__m128 sp = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(half, _mm_sub_ps(one, h)), zero));
+		sp = _mm_or_ps(sp, _mm_andnot_ps(_mm_and_ps(sign, dy), sign));
+
+		__m128 qw = _mm_mul_ps(cy, cp), qx = _mm_mul_ps(cy, sp), qy = _mm_mul_ps(sy, cp), qz = _mm_xor_ps(sign, _mm_mul_ps(sy, sp));
+		_mm_storeu_ps(b.orientW + i, Select(moving, qw, _mm_loadu_ps(b.orientW + i)));
+		_mm_storeu_ps(b.orientX + i, Select(moving, qx, _mm_loadu_ps(b.orientX + i)));
+		_mm_storeu_ps(b.orientY + i, Select(moving, qy, _mm_loadu_ps(b.orientY + i)));
+		_mm_storeu_ps(b.orientZ + i, Select(moving, qz, _mm_loadu_ps(b.orientZ + i)));
+	}
+
+	SteerProjectilesScalar(b, i, b.count);
+}
+
+#else
+
+void IntegrateKinematics(KinematicsBatch& b, std::vector<int>& landed)
+{
+	IntegrateKinematicsScalar(b, 0, b.count, landed);
+}
+
+void SteerProjectiles(SteeringBatch& b)
+{
+	SteerProjectilesScalar(b, 0, b.count);
+}
+
+#endif
+
+} // namespace game
@@ -0,0 +1,52 @@
+#ifndef KINEMATICS_H_
+#define KINEMATICS_H_
+
+#include <vector>
+
+namespace game {
+
+	// struct KinematicsBatch
+	// Pointers into structure-of-arrays entity state, processed together by IntegrateKinematics
+	struct KinematicsBatch {
+		float *posX, *posY, *posZ;
+		float *velX, *velY, *velZ;
+		int *grounded;
+		int count;
+
+		float gravity;		// Added to the vertical velocity of airborne entities each tick
+		float minBound;		// Positions are clamped to [minBound, maxBound] on every axis
+		float maxBound;
+	};
+
+	// Apply gravity, ground contact, velocity and the bounds clamp to every entity in the batch
+	// Indices of entities that touched the ground this tick are appended to 'landed'
+	// Uses AVX2 (8 at a time) or SSE2 (4 at a time) when available, with a scalar tail
+	void IntegrateKinematics(KinematicsBatch& batch, std::vector<int>& landed);
+
+	// Reference implementation, one entity at a time
+	void IntegrateKinematicsScalar(KinematicsBatch& batch, int begin, int end, std::vector<int>& landed);
+
+	// struct SteeringBatch
+	// Pointers into structure-of-arrays projectile state, processed together by SteerProjectiles
+	struct SteeringBatch {
+		const float *posX, *posY, *posZ;
+		float *velX, *velY, *velZ;
+		const float *maxSpeed;		// Homing speed, 0 for projectiles flying straight
+		float *orientW, *orientX, *orientY, *orientZ;	// Facing as a quaternion: +z along the velocity, no roll
+		int count;
+
+		float targetX, targetY, targetZ;	// Where every homing projectile turns to, taken once per tick
+		float turn;			// How hard they turn, per tick and per unit of distance
+	};
+
+	// Turn homing projectiles towards the target at their full speed, then face every moving projectile
+	// along its velocity. The facing is worked out from half-angle identities, so there is no trig and
+	// no branch and the whole batch runs 8 or 4 at a time like IntegrateKinematics
+	void SteerProjectiles(SteeringBatch& batch);
+
+	// Reference implementation, one projectile at a time
+	void SteerProjectilesScalar(SteeringBatch& batch, int begin, int end);
+
+} // namespace game
+
+#endif // KINEMATICS_H_
@@ -1,158 +1,353 @@
+#include <algorithm>
+#include <stdexcept>
+
 #include "map_generator.h"
+#include "entity_game_nodes.h"
 
 namespace game {
 
+// Regions kept in the scene around the camera's region, in each direction
+// Regions one further than this are left alone, so crossing a border back and forth doesn't regenerate anything
+const int load_regions_g = 1;
+
+// Nodes created per frame, keeps a region arriving from hitching the frame it lands in
+const int commit_budget_g = 48;
+
+// Mix the world seed and a region's coordinates into the seed of that region
+static uint32_t RegionSeed(uint32_t seed, int x, int z)
+{
+	uint32_t h = seed ^ ((uint32_t)x * 0x8DA6B343u) ^ ((uint32_t)z * 0xD8163841u);
+	h = (h ^ (h >> 16)) * 0x85EBCA6Bu;
+	h = (h ^ (h >> 13)) * 0xC2B2AE35u;
+	return h ^ (h >> 16);
+}
 
 
-	MapGenerator::MapGenerator(SceneGraph* sceneGraph, int initWidth, int initHeight) : cellSize (20)
+	MapGenerator::MapGenerator(SceneGraph* sceneGraph, const ObjectCatalogue* catalogue, uint32_t seed, int regionSize) : regionSize(regionSize), cellSize (20)
 	{
 		scene = sceneGraph;
+		mSeed = seed;
+
+		mCatalogue = catalogue;
+		mHay = catalogue->find("hay");
+		mTree = catalogue->find("tree");
+		mBarn = catalogue->find("barn");
+		if (mHay < 0 || mTree < 0 || mBarn < 0) {
+			throw(std::invalid_argument(std::string("Object catalogue needs hay, tree and barn")));
+		}
 
 		// Initialise map variables
-		width = initWidth * 100;
-		height = initHeight * 100;
-		gridWidth = width / cellSize;
-		gridHeight = height / cellSize;
+		gridWidth = regionSize / cellSize;
+		gridHeight = regionSize / cellSize;
 		difficulty = 1;
 
 		density = 1;
-		cowCount;
-		enemyCount;
-		for (int i = 0; i < gridWidth; i++) {
-			std::vector<std::vector<Object>> column(gridHeight, std::vector<Object>());	
-			grid.push_back(column);
-		}
+
+		mRunning = true;
+		mWorker = std::thread(&MapGenerator::WorkerLoop, this);
 	}
 
 
 	MapGenerator::~MapGenerator()
 	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRunning = false;
+		}
+		mWake.notify_all();
+		mWorker.join();
 	}
 
-	void MapGenerator::GenerateMap()
+	void MapGenerator::update(glm::vec3 center)
 	{
+		int centerX = (int)floor(center.x / regionSize);
+		int centerZ = (int)floor(center.z / regionSize);
+
+		// Remove the regions left behind
+		std::vector<int64_t> evicted;
+		for (auto& entry : mRegions) {
+			int x = (int)(entry.first >> 32);
+			int z = (int)(int32_t)(entry.first & 0xFFFFFFFF);
+			if (std::abs(x - centerX) <= load_regions_g + 1 && std::abs(z - centerZ) <= load_regions_g + 1) continue;
 
-		//Begin by creating a ground plane
-		for (int i = 0; i < width/100; i++) {
-			for (int j = 0; j < height/100; j++) {
-				SceneNode* ground = scene->CreateInstance<SceneNode>("Ground" + std::to_string(i) + std::to_string(j), "GridMesh", "litTextureMaterial", "groundTexture");
-				ground->translate(glm::vec3(i * 100, 0, j * 100));
+			if (entry.second != Queued) {
+				// Everything generated that is still standing in the region goes, including entities that wandered in
+				scene->deleteArea(glm::vec2(x, z) * (float)regionSize, glm::vec2(x + 1, z + 1) * (float)regionSize, "generated");
+			}
+			else {
+				std::lock_guard<std::mutex> lock(mMutex);
+				mRequests.erase(std::remove(mRequests.begin(), mRequests.end(), std::make_pair(x, z)), mRequests.end());
+			}
+			evicted.push_back(entry.first);
+		}
+		for (int64_t k : evicted) {
+			mRegions.erase(k);
+		}
+
+		// Request the regions coming into range, nearest first
+		std::vector<std::pair<int, std::pair<int, int>>> missing;
+		for (int x = centerX - load_regions_g; x <= centerX + load_regions_g; x++) {
+			for (int z = centerZ - load_regions_g; z <= centerZ + load_regions_g; z++) {
+				if (mRegions.find(key(x, z)) != mRegions.end()) continue;
+				missing.push_back(std::make_pair(std::abs(x - centerX) + std::abs(z - centerZ), std::make_pair(x, z)));
+				mRegions[key(x, z)] = Queued;
+			}
+		}
+		if (!missing.empty()) {
+			std::sort(missing.begin(), missing.end());
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				for (auto& m : missing) {
+					mRequests.push_back(m.second);
+				}
 			}
+			mWake.notify_one();
 		}
 
+		// Pick up the finished regions, unless they went out of range in the meantime
+		std::vector<Region> finished;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			finished.swap(mFinished);
+		}
+		for (Region& region : finished) {
+			auto it = mRegions.find(key(region.x, region.z));
+			if (it == mRegions.end() || it->second != Queued) continue;
+
+			it->second = Committing;
+			mCommits.push_back(std::move(region));
+		}
+
+		// Add a batch of placements to the scene, oldest region first
+		int budget = commit_budget_g;
+		while (budget > 0 && !mCommits.empty()) {
+			Region& region = mCommits.front();
+			auto it = mRegions.find(key(region.x, region.z));
+			if (it != mRegions.end() && it->second == Committing) {
+				budget -= CommitRegion(region, budget);
+				if (region.committed < region.placements.size()) break;
+				it->second = Loaded;
+			}
+			mCommits.pop_front();
+		}
+	}
+
+	void MapGenerator::WorkerLoop(void)
+	{
+		for (;;) {
+			Region region;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [this] { return !mRunning || !mRequests.empty(); });
+				if (!mRunning) return;
+
+				region.x = mRequests.front().first;
+				region.z = mRequests.front().second;
+				mRequests.pop_front();
+			}
+
+			GenerateRegion(region);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFinished.push_back(std::move(region));
+		}
+	}
+
+	void MapGenerator::GenerateRegion(Region& region) const
+	{
+		// Everything random in the region comes from its own seed
+		uint32_t seed = RegionSeed(mSeed, region.x, region.z);
+		Random random(seed);
+
+		glm::vec2 origin = glm::vec2(region.x, region.z) * (float)regionSize;
+		Grid grid(gridWidth, std::vector<std::vector<Object>>(gridHeight, std::vector<Object>()));
+
 		// Generate random points
-		const auto Points = PoissonGenerator::generatePoissonPoints((gridWidth+1) * (gridHeight+1) * density, PRNG,50,false, 1/(density * glm::min(gridWidth, gridHeight)));
-		//const auto Points = PoissonGenerator::generatePoissonPoints(1, PRNG, 50, false, 1 / (density * glm::min(gridWidth, gridHeight)));
+		const auto Points = GeneratePoissonPoints((gridWidth+1) * (gridHeight+1) * density, random,50,false, 1/(density * glm::min(gridWidth, gridHeight)));
 
 		// Sort the random points into grid cells based off theer position
 		for (auto p : Points) {
 			Object point;
-			point.pos = glm::vec2(p.x * width, p.y * height);
-			point.a = floor(point.pos.x / cellSize); 
+			point.pos = glm::vec2(p.x * regionSize, p.y * regionSize);
+			point.a = floor(point.pos.x / cellSize);
 			point.b = floor(point.pos.y / cellSize);
-			point.type = "hay";
-			int r = rand() % 100;
+			point.type = mHay;
+			int r = random.range(100);
 			if (r < 15) {
-				point.type = "originPoint";
+				point.type = origin_point_g;
 			}
 			grid.at(point.a).at(point.b).push_back(point);
 		}
-		
-		// Generate tight clusters of objects around certain points 
+
+		// Generate tight clusters of objects around certain points
 		for (int x = 0; x < gridWidth; x++) {
 			for (int y = 0; y < gridHeight; y++) {
 				for (int i = 0; i <grid.at(x).at(y).size(); i++) {
-					if (grid.at(x).at(y).at(i).type == "originPoint") {
-						GenerateCluster(grid.at(x).at(y).at(i));
+					if (grid.at(x).at(y).at(i).type == origin_point_g) {
+						GenerateCluster(grid.at(x).at(y).at(i), grid, random);
 					}
 				}
 			}
 		}
-		
-		// Create objects at each point
+
+		// Turn the objects that end up in the scene into placements, in world coordinates
 		for (int x = 0; x < gridWidth; x++) {
 			for (int y = 0; y < gridHeight; y++) {
-				for (auto o : grid.at(x).at(y)) {
-					if (!(o.type == "default" || o.type == "originPoint")) {
-
-						if (o.type == "hay") {
-							EntityNode* obj = scene->CreateInstance<EntityNode>(o.type + std::to_string(x) + std::to_string(y), o.type + "Mesh", "litTextureMaterial", o.type + "Texture");
-							obj->translate(glm::vec3(o.pos.x, 0, o.pos.y));
-							obj->rotate(glm::angleAxis(glm::half_pi<float>(), glm::vec3(0, 0, 1)));
-							//obj->rotate(glm::angleAxis((rand()%360) * (glm::pi<float>() / 180), glm::vec3(-1, 0, 0)));
-							obj->translate(glm::vec3(0, 0.5, 0));
-							obj->addTag("canPickUp");
-							obj->addTag("canCollect");
-
-						}
-						else {
-							SceneNode* obj = scene->CreateInstance<SceneNode>(o.type + std::to_string(x) + std::to_string(y), o.type + "Mesh", "litTextureMaterial", o.type + "Texture");
-							obj->translate(glm::vec3(o.pos.x, 0, o.pos.y));
-							if (o.type == "tree") {
-								obj->scale(glm::vec3(1.25f + rand() % 5 / 10.0f));
-							}
-							if (o.type == "barn") {
-								obj->rotate(glm::angleAxis(glm::radians(o.rotation), glm::vec3(0, 1, 0)));
-								obj->scale(glm::vec3(1.3f + rand() % 80 / 100.0f, 1.3f + rand() % 80 / 100.0f, 1.3f + rand() % 80 / 100.0f));
-							}
-						}
-					}
+				for (const Object& o : grid.at(x).at(y)) {
+					if (o.type < 0) continue;
+
+					Placement placement;
+					placement.pos = origin + o.pos;
+					placement.rotation = o.rotation;
+					placement.scale = glm::vec3(1.0f);
+					placement.type = o.type;
 
+					if (o.type == mTree) {
+						placement.scale = glm::vec3(1.25f + random.range(5) / 10.0f);
+					}
+					else if (o.type == mBarn) {
+						placement.scale = glm::vec3(1.3f + random.range(80) / 100.0f, 1.3f + random.range(80) / 100.0f, 1.3f + random.range(80) / 100.0f);
+					}
+					region.placements.push_back(placement);
 				}
 			}
 		}
 
+		// Types the catalogue scatters freely (animals, farmers, cannons) anywhere in the region
+		for (int type = 0; type < mCatalogue->getCount(); type++) {
+			for (int i = 0; i < mCatalogue->get(type).count; i++) {
+				Placement placement;
+				placement.pos = origin + glm::vec2(random.range(regionSize), random.range(regionSize));
+				placement.rotation = 0;
+				placement.scale = glm::vec3(1.0f);
+				placement.type = type;
+				region.placements.push_back(placement);
+			}
+		}
+	}
+
+	int MapGenerator::CommitRegion(Region& region, int budget)
+	{
+		std::string suffix = "_" + std::to_string(region.x) + "_" + std::to_string(region.z) + "_";
+
+		int end = std::min((int)region.placements.size(), region.committed + budget);
+		int count = end - region.committed;
+		for (int i = region.committed; i < end; i++) {
+			const Placement& p = region.placements[i];
+			const ObjectType& type = mCatalogue->get(p.type);
+			std::string name = type.name + suffix + std::to_string(i);
+			SceneNode* obj;
+
+			// Resources were looked up when the catalogue was loaded
+			switch (type.objectClass) {
+			case EntityObject:
+				obj = scene->CreateNode<EntityNode>(name, type.geometry, type.material, type.texture);
+				break;
+			case CowObject:
+				obj = scene->CreateNode<CowEntityNode>(name, type.geometry, type.material, type.texture);
+				break;
+			case BullObject:
+				obj = scene->CreateNode<BullEntityNode>(name, type.geometry, type.material, type.texture);
+				break;
+			case FarmerObject:
+				obj = scene->CreateNode<FarmerEntityNode>(name, type.geometry, type.material, type.texture);
+				break;
+			case CannonObject:
+				obj = scene->CreateNode<CannonMissileEntityNode>(name, type.geometry, type.material, type.texture);
+				break;
+			case StaticObject:
+			default:
+				obj = scene->CreateNode<SceneNode>(name, type.geometry, type.material, type.texture);
+				break;
+			}
+
+			obj->translate(glm::vec3(p.pos.x, type.lift, p.pos.y));
+			if (p.rotation != 0) {
+				obj->rotate(glm::angleAxis(glm::radians(p.rotation), glm::vec3(0, 1, 0)));
+			}
+			if (type.roll != 0) {
+				obj->rotate(glm::angleAxis(glm::radians(type.roll), glm::vec3(0, 0, 1)));
+			}
+			glm::vec3 scale = type.scale * p.scale;
+			if (scale != glm::vec3(1.0f)) {
+				obj->scale(scale);
+			}
 
+			obj->setCollisionType(type.shape);
+			for (const std::string& tag : type.tags) {
+				obj->addTag(tag);
+			}
+			// Removed with the region
+			obj->addTag("generated");
+		}
 
+		region.committed = end;
+		return count;
 	}
 
 
 
-	void MapGenerator::GenerateCluster(Object origin)
+	void MapGenerator::FindNear(Grid& grid, glm::vec2 center, float radius, std::vector<Object*>& out) const
 	{
-		// Generate a tight cluster of objects around an origin point
-		bool isBarnCluster = (rand() % 100) < 20;
-		// The objects we generate are either trees or houses/barns
+		// Only the cells overlapping the circle, clipped to the region
+		int minA = std::max((int)floor((center.x - radius) / cellSize), 0);
+		int maxA = std::min((int)floor((center.x + radius) / cellSize), gridWidth - 1);
+		int minB = std::max((int)floor((center.y - radius) / cellSize), 0);
+		int maxB = std::min((int)floor((center.y + radius) / cellSize), gridHeight - 1);
 
-		//erase any points in adjacent cells to avoid overlap
-		float radius = (isBarnCluster) ? cellSize : (1 + (rand() % 5) / 5.0f) * cellSize;
-		for (int x = -1; x < 1; x++) {
-			for (int y = -1; y < 1; y++) {
-				// if the origin is on the border of the map, do not look for points outside the map
-				if (origin.a + x < 0 || origin.a + x > gridWidth - 1 || origin.b + y < 0 || origin.b + y > gridHeight - 1) continue;
-				// look in adjacent grid cells and ignore points within radius
-				for (auto point : grid.at(origin.a + x).at(origin.b + y)) {
-					if (glm::distance(origin.pos, point.pos) < radius) {
-						point.type = "default";
+		for (int a = minA; a <= maxA; a++) {
+			for (int b = minB; b <= maxB; b++) {
+				for (Object& o : grid.at(a).at(b)) {
+					glm::vec2 d = o.pos - center;
+					if (glm::dot(d, d) < radius * radius) {
+						out.push_back(&o);
 					}
 				}
 			}
 		}
+	}
+
+	void MapGenerator::GenerateCluster(const Object& origin, Grid& grid, Random& random) const
+	{
+		// 'origin' lives in the grid, which grows below
+		const glm::vec2 center = origin.pos;
+
+		// Generate a tight cluster of objects around an origin point
+		bool isBarnCluster = random.range(100) < 20;
+		// The objects we generate are either trees or houses/barns
+
+		// Clear every point within the cluster's radius to avoid overlap, including origins of clusters not generated yet
+		float radius = (isBarnCluster) ? cellSize : (1 + random.range(5) / 5.0f) * cellSize;
+		std::vector<Object*> near;
+		FindNear(grid, center, radius, near);
+		for (Object* point : near) {
+			point->type = no_object_g;
+		}
 
 		// Now that we've cleared some space, generate the cluster of objects
 		int n;
-		n = (isBarnCluster) ? rand() % 6 + 1 : rand() % 30 + 10;
-		const auto Points = PoissonGenerator::generatePoissonPoints(n, PRNG, 70);
+		n = (isBarnCluster) ? random.range(6) + 1 : random.range(30) + 10;
+		const auto Points = GeneratePoissonPoints(n, random, 70);
 		for (auto p : Points) {
 			Object point;
-			point.pos = origin.pos +  glm::vec2(p.x * radius, p.y * radius) - radius/2.0f; //position the randomly generated point around the origin
+			point.pos = center +  glm::vec2(p.x * radius, p.y * radius) - radius/2.0f; //position the randomly generated point around the origin
 			point.a = floor(point.pos.x / cellSize);
 			point.b = floor(point.pos.y / cellSize);
 			if (point.a > gridWidth - 1 || point.a < 0 || point.b > gridHeight - 1 || point.b < 0) continue;
 
 			if (isBarnCluster) {
-				point.type = "barn";
-				switch (rand() % 3) {
+				point.type = mBarn;
+				switch (random.range(3)) {
 				case 0: point.rotation = 0;  break;
 				case 1: point.rotation = 90;  break;
-				case 2: point.rotation = glm::orientedAngle(glm::normalize(origin.pos), glm::normalize(point.pos - origin.pos));  break;
+				case 2: point.rotation = glm::orientedAngle(glm::normalize(center), glm::normalize(point.pos - center));  break;
 				}
 			}
 			else {
-				point.type = "tree";
+				point.type = mTree;
 			}
 			grid.at(point.a).at(point.b).push_back(point);
 		}
-		
+
 	}
-}
\ No newline at end of file
+}
@@ -5,61 +5,126 @@
 
 #include <exception>
 #include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <stdint.h>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include <glm/gtx/vector_angle.hpp>
 
-#define POISSON_PROGRESS_INDICATOR 1
-#include "PoissonGenerator.h"
+#include "poisson_sampler.h"
 
 
 #include "scene_graph.h"
 #include "resource_manager.h"
 #include "entity_node.h"
+#include "random.h"
+#include "object_catalogue.h"
 
 
 namespace game {
 
+	// Object types that are not in the catalogue
+	const int no_object_g = -1;		// Cleared to make room for a cluster
+	const int origin_point_g = -2;	// Centre of a cluster, nothing is placed there
+
 	// struct Object
 	// An object on the map. Purely abstract - does not exist in the scene
 	struct Object {
 		glm::vec2 pos;
 		int a = 0, b = 0;
-		std::string type = "default";
+		int type = no_object_g;		// Id in the ObjectCatalogue
 		float rotation = 0;
 	};
 
+	// struct Placement
+	// One node to create, everything the main thread needs to know about it
+	struct Placement {
+		glm::vec2 pos;		// World position on the ground
+		float rotation;		// Degrees about the vertical axis
+		glm::vec3 scale;	// On top of the type's own scale
+		int type;			// Id in the ObjectCatalogue
+	};
+
+	// struct Region
+	// A square of the world, generated as a unit from the world seed and its coordinates
+	struct Region {
+		int x, z;
+		std::vector<Placement> placements;
+		int committed = 0;	// Placements already in the scene
+	};
+
 	// class MapGenerator
 	// Handles map generation
+	// The world is split into regions that are generated on a background thread as the camera approaches
+	// and removed from the scene once it leaves. A region always comes out the same for the same world seed,
+	// so leaving and coming back gives the same layout, and only the regions around the camera take memory
+	// Generation only produces a list of placements; the main thread turns them into nodes a few at a time
 	class MapGenerator
 	{
 	public:
-		MapGenerator(SceneGraph* sceneGraph, int initWidth = 3, int initHeight = 3);
+		// 'catalogue' must hold "hay", "tree" and "barn"
+		MapGenerator(SceneGraph* sceneGraph, const ObjectCatalogue* catalogue, uint32_t seed, int regionSize = 300);
 		~MapGenerator();
-		void GenerateMap();
+
+		// Request the regions coming into range of 'center', add a batch of finished placements to the scene
+		// and remove the regions left behind. Main thread only, called every frame
+		void update(glm::vec3 center);
+
+		inline int getRegionCount() const { return (int)mRegions.size(); }
 
 	private:
+		typedef std::vector<std::vector<std::vector<Object>>> Grid;
+
 		// Scene graph containing all nodes to render
 		SceneGraph* scene;
 
-		PoissonGenerator::DefaultPRNG PRNG;
-		void GenerateCluster(Object origin);
+		// What can be placed, and the ids of the types the generator places itself
+		const ObjectCatalogue* mCatalogue;
+		int mHay, mTree, mBarn;
+
+		uint32_t mSeed;
+		const int regionSize;
+
+		// Generation, run on the worker. Only touches the region and the locals it is given
+		void GenerateRegion(Region& region) const;
+		void GenerateCluster(const Object& origin, Grid& grid, Random& random) const;
+		// Append every object within 'radius' of 'center' (region coordinates) to 'out'
+		void FindNear(Grid& grid, glm::vec2 center, float radius, std::vector<Object*>& out) const;
+
+		// Create the scene nodes for up to 'budget' more placements of a region, returns how many were created
+		int CommitRegion(Region& region, int budget);
 
 		//Generate points
 		int gridWidth;
 		int gridHeight;
 		const int cellSize;
-		int width;
-		int height;
 		int difficulty;
 
 		float density;
-		int cowCount;
-		int enemyCount;
 
-		std::vector<std::vector<std::vector<Object>>> grid;
+		// Regions requested or in the scene
+		enum RegionState { Queued, Committing, Loaded };
+		std::unordered_map<int64_t, RegionState> mRegions;
+		inline static int64_t key(int x, int z) { return ((int64_t)x << 32) | (uint32_t)z; }
+
+		// Background generation
+		std::thread mWorker;
+		std::mutex mMutex;
+		std::condition_variable mWake;		// Signalled when a region is requested or the worker should stop
+		bool mRunning;
+		std::deque<std::pair<int, int>> mRequests;	// Regions waiting for the worker, nearest first
+		std::vector<Region> mFinished;		// Generated, waiting to be picked up by the main thread
+
+		std::deque<Region> mCommits;		// Being added to the scene, main thread only
+
+		void WorkerLoop(void);
 
 	};
 
@@ -0,0 +1,289 @@
+#include <cmath>
+#include <queue>
+#include <algorithm>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "mesh_simplify.h"
+
+namespace game {
+
+// Weight of the planes that hold open edges in place
+const double boundary_weight_g = 1000.0;
+
+// A collapse is rejected if it turns any remaining face by more than this (cosine of the angle)
+const float max_flip_cos_g = 0.2f;
+
+
+// Symmetric 4x4 error quadric, upper triangle only
+struct Quadric {
+	double a[10];
+
+	Quadric()
+	{
+		for (int i = 0; i < 10; i++) a[i] = 0.0;
+	}
+
+	// Squared distance to the plane ax + by + cz + d = 0, scaled by 'weight'
+	Quadric(double x, double y, double z, double d, double weight)
+	{
+		a[0] = weight * x * x; a[1] = weight * x * y; a[2] = weight * x * z; a[3] = weight * x * d;
+		a[4] = weight * y * y; a[5] = weight * y * z; a[6] = weight * y * d;
+		a[7] = weight * z * z; a[8] = weight * z * d;
+		a[9] = weight * d * d;
+	}
+
+	void add(const Quadric& q)
+	{
+		for (int i = 0; i < 10; i++) a[i] += q.a[i];
+	}
+
+	double error(const glm::vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+			+ a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+			+ a[7] * z * z + 2.0 * a[8] * z
+			+ a[9];
+	}
+
+	// Position with the least error, if the quadric is not degenerate
+	bool optimum(glm::vec3& p) const
+	{
+		double det = a[0] * (a[4] * a[7] - a[5] * a[5]) - a[1] * (a[1] * a[7] - a[5] * a[2]) + a[2] * (a[1] * a[5] - a[4] * a[2]);
+		if (std::abs(det) < 1e-12)
+			return false;
+
+		// Cramer's rule on the 3x3 system A p = -b
+		double bx = -a[3], by = -a[6], bz = -a[8];
+		double dx = bx * (a[4] * a[7] - a[5] * a[5]) - a[1] * (by * a[7] - a[5] * bz) + a[2] * (by * a[5] - a[4] * bz);
+		double dy = a[0] * (by * a[7] - bz * a[5]) - bx * (a[1] * a[7] - a[5] * a[2]) + a[2] * (a[1] * bz - by * a[2]);
+		double dz = a[0] * (a[4] * bz - a[5] * by) - a[1] * (a[1] * bz - by * a[2]) + bx * (a[1] * a[5] - a[4] * a[2]);
+		p = glm::vec3((float)(dx / det), (float)(dy / det), (float)(dz / det));
+		return true;
+	}
+};
+
+// Candidate edge collapse, v is merged into u
+struct Collapse {
+	double cost;
+	int u, v;
+	unsigned int stampU, stampV;
+	glm::vec3 target;
+
+	// Inverted, so the priority queue pops the cheapest collapse first
+	bool operator<(const Collapse& other) const { return cost > other.cost; }
+};
+
+static inline uint64_t EdgeKey(int a, int b)
+{
+	if (a > b) std::swap(a, b);
+	return ((uint64_t)a << 32) | (uint32_t)b;
+}
+
+static glm::vec3 FaceNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+	return glm::cross(p1 - p0, p2 - p0);
+}
+
+
+class Simplifier {
+
+public:
+	Simplifier(const TriMesh& mesh)
+		: mPosition(mesh.position)
+		, mFace(mesh.face)
+		, mFaceAlive(mesh.face.size(), true)
+		, mVertexFaces(mesh.position.size())
+		, mVertexAlive(mesh.position.size(), true)
+		, mStamp(mesh.position.size(), 0)
+		, mQuadric(mesh.position.size())
+	{
+		std::unordered_map<uint64_t, int> edgeUse;
+
+		for (int f = 0; f < (int)mFace.size(); f++) {
+			const Face& face = mFace[f];
+			for (int j = 0; j < 3; j++) {
+				mVertexFaces[face.i[j]].push_back(f);
+				edgeUse[EdgeKey(face.i[j], face.i[(j + 1) % 3])]++;
+			}
+
+			// Every face adds its plane to its corners
+			glm::vec3 n = FaceNormal(mPosition[face.i[0]], mPosition[face.i[1]], mPosition[face.i[2]]);
+			float area = glm::length(n);
+			if (area <= 0.0f)
+				continue;
+			n /= area;
+			Quadric q(n.x, n.y, n.z, -glm::dot(n, mPosition[face.i[0]]), 1.0);
+			for (int j = 0; j < 3; j++)
+				mQuadric[face.i[j]].add(q);
+		}
+
+		// Open edges get a steep plane through them, perpendicular to their face
+		for (int f = 0; f < (int)mFace.size(); f++) {
+			const Face& face = mFace[f];
+			glm::vec3 n = FaceNormal(mPosition[face.i[0]], mPosition[face.i[1]], mPosition[face.i[2]]);
+			for (int j = 0; j < 3; j++) {
+				int a = face.i[j], b = face.i[(j + 1) % 3];
+				if (edgeUse[EdgeKey(a, b)] != 1)
+					continue;
+
+				glm::vec3 side = glm::cross(mPosition[b] - mPosition[a], n);
+				float length = glm::length(side);
+				if (length <= 0.0f)
+					continue;
+				side /= length;
+				Quadric q(side.x, side.y, side.z, -glm::dot(side, mPosition[a]), boundary_weight_g);
+				mQuadric[a].add(q);
+				mQuadric[b].add(q);
+			}
+		}
+
+		for (auto& edge : edgeUse) {
+			pushCollapse((int)(edge.first >> 32), (int)(edge.first & 0xFFFFFFFFu));
+		}
+	}
+
+	TriMesh run(const TriMesh& mesh, int targetFaces)
+	{
+		int alive = (int)mFace.size();
+
+		while (alive > targetFaces && !mHeap.empty())
+		{
+			Collapse c = mHeap.top();
+			mHeap.pop();
+
+			// One of the vertices changed since this was computed
+			if (!mVertexAlive[c.u] || !mVertexAlive[c.v] || mStamp[c.u] != c.stampU || mStamp[c.v] != c.stampV)
+				continue;
+			if (flips(c.u, c.v, c.target) || flips(c.v, c.u, c.target))
+				continue;
+
+			alive -= collapse(c.u, c.v, c.target);
+		}
+
+		TriMesh out;
+		out.position = mPosition;
+		out.normal = mesh.normal;
+		out.tex_coord = mesh.tex_coord;
+		for (int f = 0; f < (int)mFace.size(); f++) {
+			if (mFaceAlive[f])
+				out.face.push_back(mFace[f]);
+		}
+		return out;
+	}
+
+private:
+	std::vector<glm::vec3> mPosition;
+	std::vector<Face> mFace;
+	std::vector<bool> mFaceAlive;
+	std::vector<std::vector<int>> mVertexFaces;
+	std::vector<bool> mVertexAlive;
+	std::vector<unsigned int> mStamp;	// Bumped whenever a vertex changes, invalidating its queued collapses
+	std::vector<Quadric> mQuadric;
+	std::priority_queue<Collapse> mHeap;
+
+	void pushCollapse(int u, int v)
+	{
+		Quadric q = mQuadric[u];
+		q.add(mQuadric[v]);
+
+		// Best position if there is one, otherwise the better of the endpoints and the midpoint
+		Collapse c;
+		c.u = u; c.v = v;
+		c.stampU = mStamp[u]; c.stampV = mStamp[v];
+		if (!q.optimum(c.target) || glm::distance(c.target, 0.5f * (mPosition[u] + mPosition[v])) > 2.0f * glm::distance(mPosition[u], mPosition[v])) {
+			glm::vec3 candidates[3] = { mPosition[u], mPosition[v], 0.5f * (mPosition[u] + mPosition[v]) };
+			c.target = candidates[0];
+			for (int i = 1; i < 3; i++) {
+				if (q.error(candidates[i]) < q.error(c.target))
+					c.target = candidates[i];
+			}
+		}
+		c.cost = q.error(c.target);
+		mHeap.push(c);
+	}
+
+	static bool contains(const Face& face, int v)
+	{
+		return face.i[0] == v || face.i[1] == v || face.i[2] == v;
+	}
+
+	// Would moving 'a' to 'target' turn over one of its faces that survive the collapse of edge (a, b)?
+	bool flips(int a, int b, const glm::vec3& target)
+	{
+		for (int f : mVertexFaces[a]) {
+			if (!mFaceAlive[f] || contains(mFace[f], b))
+				continue;
+
+			const Face& face = mFace[f];
+			glm::vec3 before = FaceNormal(mPosition[face.i[0]], mPosition[face.i[1]], mPosition[face.i[2]]);
+			glm::vec3 p[3];
+			for (int j = 0; j < 3; j++)
+				p[j] = face.i[j] == a ? target : mPosition[face.i[j]];
+			glm::vec3 after = FaceNormal(p[0], p[1], p[2]);
+
+			float lengths = glm::length(before) * glm::length(after);
+			if (lengths <= 0.0f || glm::dot(before, after) < max_flip_cos_g * lengths)
+				return true;
+		}
+		return false;
+	}
+
+	// Merge v into u, returns the number of faces removed
+	int collapse(int u, int v, const glm::vec3& target)
+	{
+		int removed = 0;
+
+		mPosition[u] = target;
+		mQuadric[u].add(mQuadric[v]);
+
+		for (int f : mVertexFaces[v]) {
+			if (!mFaceAlive[f])
+				continue;
+
+			Face& face = mFace[f];
+			if (contains(face, u)) {
+				// The collapsed edge belonged to this face
+				mFaceAlive[f] = false;
+				removed++;
+				continue;
+			}
+			for (int j = 0; j < 3; j++) {
+				if (face.i[j] == v) face.i[j] = u;
+			}
+			mVertexFaces[u].push_back(f);
+		}
+
+		mVertexAlive[v] = false;
+		mVertexFaces[v].clear();
+		mStamp[u]++;
+		mStamp[v]++;
+
+		// Drop dead faces from u and queue the edges around it again
+		std::vector<int>& faces = mVertexFaces[u];
+		faces.erase(std::remove_if(faces.begin(), faces.end(), [this](int f) { return !mFaceAlive[f]; }), faces.end());
+
+		std::vector<int> neighbours;
+		for (int f : faces) {
+			for (int j = 0; j < 3; j++) {
+				int n = mFace[f].i[j];
+				if (n != u && std::find(neighbours.begin(), neighbours.end(), n) == neighbours.end())
+					neighbours.push_back(n);
+			}
+		}
+		for (int n : neighbours)
+			pushCollapse(u, n);
+
+		return removed;
+	}
+};
+
+
+TriMesh SimplifyMesh(const TriMesh& mesh, int targetFaces)
+{
+	Simplifier simplifier(mesh);
+	return simplifier.run(mesh, targetFaces);
+}
+
+} // namespace game
@@ -0,0 +1,17 @@
+#ifndef MESH_SIMPLIFY_H_
+#define MESH_SIMPLIFY_H_
+
+#include <vector>
+
+#include "model_loader.h"
+
+namespace game {
+
+	// Reduce 'mesh' to at most 'targetFaces' triangles by quadric error edge collapse (Garland & Heckbert)
+	// Open edges are weighted heavily so silhouettes survive. Corners keep their texture coordinate and
+	// normal indices, which is good enough at the distances simplified meshes are drawn from.
+	TriMesh SimplifyMesh(const TriMesh& mesh, int targetFaces);
+
+} // namespace game
+
+#endif // MESH_SIMPLIFY_H_
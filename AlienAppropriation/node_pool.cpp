@@ -0,0 +1,111 @@
+#include <new>
+#include <cstddef>
+#include <string.h>
+
+#include "node_pool.h"
+
+namespace game {
+
+// Nodes per block, a pool grows by one block when its free list runs out
+const size_t slots_per_block_g = 64;
+
+// Slots are rounded up to this so every node is as aligned as the global operator new would make it
+const size_t slot_alignment_g = alignof(std::max_align_t);
+
+std::vector<NodePool::Pool> NodePool::mPools;
+std::vector<NodePool::HandleSlot> NodePool::mHandles;
+std::vector<uint32_t> NodePool::mFreeHandles;
+int NodePool::mLive = 0;
+size_t NodePool::mReserved = 0;
+
+
+NodePool::Pool& NodePool::getPool(size_t size)
+{
+	size = (size + slot_alignment_g - 1) / slot_alignment_g * slot_alignment_g;
+
+	// A handful of node types, a linear search is all it takes
+	for (Pool& pool : mPools) {
+		if (pool.size == size)
+			return pool;
+	}
+
+	Pool pool;
+	pool.size = size;
+	mPools.push_back(pool);
+	return mPools.back();
+}
+
+void* NodePool::allocate(size_t size)
+{
+	Pool& pool = getPool(size);
+
+	if (pool.freeSlots.empty()) {
+		char* block = static_cast<char*>(::operator new(pool.size * slots_per_block_g));
+		pool.blocks.push_back(block);
+		mReserved += pool.size * slots_per_block_g;
+
+		// Handed out from the front of the block first
+		for (size_t i = slots_per_block_g; i > 0; i--) {
+			pool.freeSlots.push_back(block + (i - 1) * pool.size);
+		}
+	}
+
+	void* memory = pool.freeSlots.back();
+	pool.freeSlots.pop_back();
+	mLive++;
+	return memory;
+}
+
+void NodePool::free(void* memory, size_t size)
+{
+	if (!memory)
+		return;
+
+	Pool& pool = getPool(size);
+
+#ifndef NDEBUG
+	// Anything still reading the node through a raw pointer gets garbage instead of a plausible object
+	memset(memory, 0xDD, pool.size);
+#endif
+
+	pool.freeSlots.push_back(memory);
+	mLive--;
+}
+
+
+NodeHandle NodePool::track(BaseNode* node)
+{
+	NodeHandle handle;
+	if (!mFreeHandles.empty()) {
+		handle.index = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else {
+		handle.index = (uint32_t)mHandles.size();
+		mHandles.push_back({ nullptr, 0 });
+	}
+
+	mHandles[handle.index].node = node;
+	handle.generation = mHandles[handle.index].generation;
+	return handle;
+}
+
+void NodePool::untrack(NodeHandle handle)
+{
+	if (handle.index >= mHandles.size() || mHandles[handle.index].generation != handle.generation)
+		return;
+
+	// Every handle still pointing here goes stale
+	mHandles[handle.index].node = nullptr;
+	mHandles[handle.index].generation++;
+	mFreeHandles.push_back(handle.index);
+}
+
+BaseNode* NodePool::resolve(NodeHandle handle)
+{
+	if (handle.index >= mHandles.size() || mHandles[handle.index].generation != handle.generation)
+		return nullptr;
+	return mHandles[handle.index].node;
+}
+
+} // namespace game
@@ -0,0 +1,70 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace game {
+
+	class BaseNode;
+
+	// struct NodeHandle
+	// Weak reference to a node. The slot it points at is reused once the node is freed,
+	// the generation tells the node it was made for from whatever lives there now.
+	struct NodeHandle {
+		uint32_t index = 0xFFFFFFFF;
+		uint32_t generation = 0;
+
+		inline bool operator==(const NodeHandle& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const NodeHandle& other) const { return !(*this == other); }
+	};
+
+	// class NodePool
+	// Storage for every scene node, through BaseNode's operator new and delete.
+	// One pool per size class: operator new is only given the object size, so pools are keyed by it rounded
+	// up to the slot alignment, and node types that come out the same size share a pool.
+	// A pool grows in blocks of fixed-size slots and keeps freed slots on a free list, so spawning and
+	// destroying missiles all session long reuses the same memory instead of going back to the heap.
+	// Also hands out the generational handles. Main thread only.
+	class NodePool {
+
+	public:
+		static void* allocate(size_t size);
+		static void free(void* memory, size_t size);
+
+		// Handles, given to every node when it is built and invalidated when it is destroyed
+		static NodeHandle track(BaseNode* node);
+		static void untrack(NodeHandle handle);
+		// The node 'handle' refers to, or nullptr if it was destroyed
+		static BaseNode* resolve(NodeHandle handle);
+
+		inline static int getLiveCount() { return mLive; }
+		// Bytes held in blocks, live or free
+		inline static size_t getReservedBytes() { return mReserved; }
+
+	private:
+		struct Pool {
+			size_t size;				// Slot size, the object size rounded up to the alignment
+			std::vector<char*> blocks;
+			std::vector<void*> freeSlots;
+		};
+
+		struct HandleSlot {
+			BaseNode* node;
+			uint32_t generation;
+		};
+
+		static std::vector<Pool> mPools;
+		static std::vector<HandleSlot> mHandles;
+		static std::vector<uint32_t> mFreeHandles;
+		static int mLive;
+		static size_t mReserved;
+
+		static Pool& getPool(size_t size);
+
+	}; // class NodePool
+
+} // namespace game
+
+#endif // NODE_POOL_H_
@@ -0,0 +1,87 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "object_catalogue.h"
+#include "resource_manager.h"
+
+namespace game {
+
+// Names of the ObjectClass values in the config file
+const char *object_class_names_g[] = { "static", "entity", "cow", "bull", "farmer", "cannon" };
+
+// Names of the CollisionType values in the config file
+const char *collision_type_names_g[] = { "point", "capsule", "box", "none" };
+
+
+static Resource *FindResource(const std::string &name, const char *filename)
+{
+	Resource *res = ResourceManager::getResource(name);
+	if (!res) {
+		throw(std::invalid_argument(std::string(filename) + ": could not find resource \"" + name + "\""));
+	}
+	return res;
+}
+
+void ObjectCatalogue::Load(const char *filename)
+{
+	std::ifstream f;
+	f.open(filename);
+	if (f.fail()) {
+		throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
+	}
+
+	std::string line;
+	while (std::getline(f, line)) {
+		std::istringstream in(line);
+		ObjectType type;
+		std::string objectClass, shape, mesh, material, texture;
+
+		// Skip blank lines and comments
+		if (!(in >> type.name) || type.name[0] == '#') continue;
+
+		in >> objectClass >> shape >> mesh >> material >> texture >> type.scale.x >> type.scale.y >> type.scale.z >> type.roll >> type.lift >> type.count;
+		if (in.fail()) {
+			throw(std::invalid_argument(std::string(filename) + ": bad line \"" + line + "\""));
+		}
+
+		int c = 0;
+		while (c < sizeof(object_class_names_g) / sizeof(object_class_names_g[0]) && objectClass != object_class_names_g[c]) c++;
+		if (c == sizeof(object_class_names_g) / sizeof(object_class_names_g[0])) {
+			throw(std::invalid_argument(std::string(filename) + ": unknown class \"" + objectClass + "\""));
+		}
+		type.objectClass = (ObjectClass)c;
+
+		int t = 0;
+		while (t < sizeof(collision_type_names_g) / sizeof(collision_type_names_g[0]) && shape != collision_type_names_g[t]) t++;
+		if (t == sizeof(collision_type_names_g) / sizeof(collision_type_names_g[0])) {
+			throw(std::invalid_argument(std::string(filename) + ": unknown shape \"" + shape + "\""));
+		}
+		type.shape = (CollisionType)t;
+
+		type.geometry = FindResource(mesh, filename);
+		type.material = FindResource(material, filename);
+		type.texture = FindResource(texture, filename);
+
+		std::string tag;
+		while (in >> tag) {
+			type.tags.push_back(tag);
+		}
+
+		mTypes.push_back(type);
+	}
+
+	f.close();
+}
+
+int ObjectCatalogue::find(const std::string &name) const
+{
+	for (int i = 0; i < mTypes.size(); i++) {
+		if (mTypes[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+} // namespace game
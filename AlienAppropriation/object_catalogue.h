@@ -0,0 +1,54 @@
+#ifndef OBJECT_CATALOGUE_H_
+#define OBJECT_CATALOGUE_H_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "resource.h"
+#include "collision.h"
+
+namespace game {
+
+	// How an object type is turned into a node
+	enum ObjectClass { StaticObject, EntityObject, CowObject, BullObject, FarmerObject, CannonObject };
+
+	// struct ObjectType
+	// Everything needed to create one kind of map object, with its resources already looked up
+	struct ObjectType {
+		std::string name;
+		ObjectClass objectClass;
+		CollisionType shape;	// Sized from the mesh bounds unless it is a point
+		Resource *geometry;
+		Resource *material;
+		Resource *texture;
+		glm::vec3 scale;	// Applied on top of the scale of each placement
+		float roll;			// Degrees about the z axis
+		float lift;			// Height above the ground
+		int count;			// Scattered freely over every region
+		std::vector<std::string> tags;
+	};
+
+	// class ObjectCatalogue
+	// The kinds of objects the map generator can place, read from a config file
+	// Generation only deals in type ids, which index straight into the catalogue
+	class ObjectCatalogue {
+
+	public:
+		// Read the types in 'filename'. Their resources must already be loaded
+		void Load(const char *filename);
+
+		// Id of the type called 'name', or -1
+		int find(const std::string &name) const;
+
+		inline const ObjectType &get(int id) const { return mTypes[id]; }
+		inline int getCount() const { return (int)mTypes.size(); }
+
+	private:
+		std::vector<ObjectType> mTypes;
+
+	}; // class ObjectCatalogue
+
+} // namespace game
+
+#endif // OBJECT_CATALOGUE_H_
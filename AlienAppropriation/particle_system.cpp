@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "particle_system.h"
+#include "scene_graph.h"
+
+namespace game {
+
+// Particle layout: position(3), velocity(3), color(3), age and lifetime(2)
+const int particle_floats_g = 11;
+
+// Most particles spawned in one update, so a pile of bursts can't flood the buffer and wipe out everything alive
+const int particle_budget_g = 4096;
+
+// Emitters spawning in one update, must match max_spawns in particleUpdate_vp.glsl
+// Any others wait for the next update
+const int max_spawns_g = 16;
+
+// Particles fall a bit slower than entities so debris hangs in the air
+const glm::vec3 particle_gravity_g(0.0f, -4.0f, 0.0f);
+
+std::vector<ParticleSystem::Source> ParticleSystem::mEmitters;
+int ParticleSystem::mNextEmitterId = 0;
+
+
+ParticleSystem::ParticleSystem(const std::string name, const Resource *updateProgram, const Resource *material, int capacity)
+	: SceneNode(name)
+	, mUpdateProgram(updateProgram->getResource())
+	, mCurrent(0)
+	, mCapacity(capacity)
+	, mCursor(0)
+	, mTime(0.0f)
+	, mQuiet(0.0f)
+	, mLongestLife(0.0f)
+{
+	mMaterial = material->getResource();
+	mTexture = 0;
+	mEnvmap = 0;
+	mMode = GL_POINTS;
+	mArrayBuffer = 0;
+	mElementArrayBuffer = 0;
+	mSize = capacity;
+	mPosition = glm::vec3(0.0f);
+	mScale = glm::vec3(1.0f);
+	radius = 0.0f;
+	collisionType = None;
+
+	// Never part of the collision sweep
+	addTag("ignore");
+
+	// Zeroed state is an age and lifetime of 0, so every slot starts dead
+	std::vector<GLfloat> state(mCapacity * particle_floats_g, 0.0f);
+	glGenBuffers(2, mBuffers);
+	for (int i = 0; i < 2; i++) {
+		glBindBuffer(GL_ARRAY_BUFFER, mBuffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, state.size() * sizeof(GLfloat), state.data(), GL_DYNAMIC_COPY);
+	}
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	glDeleteBuffers(2, mBuffers);
+}
+
+
+int ParticleSystem::addEmitter(const Emitter &emitter)
+{
+	Source source;
+	source.id = mNextEmitterId++;
+	source.emitter = emitter;
+	source.owed = 0.0f;
+	mEmitters.push_back(source);
+	return source.id;
+}
+
+void ParticleSystem::setEmitterPosition(int id, glm::vec3 position)
+{
+	for (Source &source : mEmitters) {
+		if (source.id == id) {
+			source.emitter.position = position;
+			return;
+		}
+	}
+}
+
+void ParticleSystem::removeEmitter(int id)
+{
+	mEmitters.erase(std::remove_if(mEmitters.begin(), mEmitters.end(), [id](const Source &source) { return source.id == id; }), mEmitters.end());
+}
+
+void ParticleSystem::burst(glm::vec3 position, int count, float speed, glm::vec3 color, float life)
+{
+	Emitter emitter;
+	emitter.position = position;
+	emitter.spread = speed;
+	emitter.color = color;
+	emitter.lifeMin = 0.5f * life;
+	emitter.lifeMax = life;
+	emitter.burst = count;
+	addEmitter(emitter);
+}
+
+
+void ParticleSystem::bindAttributes(GLuint program, GLuint buffer, std::vector<GLint> &enabled)
+{
+	const char *names[] = { "position", "velocity", "color", "life" };
+	const int sizes[] = { 3, 3, 3, 2 };
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	int offset = 0;
+	for (int i = 0; i < 4; i++) {
+		// The draw program doesn't read every attribute
+		GLint att = glGetAttribLocation(program, names[i]);
+		if (att >= 0) {
+			glVertexAttribPointer(att, sizes[i], GL_FLOAT, GL_FALSE, particle_floats_g * sizeof(GLfloat), (void *)(offset * sizeof(GLfloat)));
+			glEnableVertexAttribArray(att);
+			enabled.push_back(att);
+		}
+		offset += sizes[i];
+	}
+}
+
+
+void ParticleSystem::update(double deltaTime)
+{
+	float dt = (float)deltaTime;
+	mTime += dt;
+
+	// How many particles every emitter wants this update
+	std::vector<int> wanted(mEmitters.size());
+	int total = 0;
+	for (size_t i = 0; i < mEmitters.size(); i++) {
+		Source &source = mEmitters[i];
+		source.owed = std::min(source.owed + source.emitter.rate * dt, (float)particle_budget_g);
+		wanted[i] = source.emitter.burst + (int)source.owed;
+		total += wanted[i];
+	}
+
+	// Over budget everyone gets the same fraction of what they asked for, the rest waits
+	int budget = std::min(particle_budget_g, mCapacity);
+	float share = total > budget ? (float)budget / total : 1.0f;
+
+	GLint first[max_spawns_g], count[max_spawns_g];
+	glm::vec3 position[max_spawns_g], velocity[max_spawns_g], color[max_spawns_g], shape[max_spawns_g];
+	int spawns = 0;
+	int spawned = 0;
+	for (size_t i = 0; i < mEmitters.size() && spawns < max_spawns_g; i++) {
+		int n = (int)(wanted[i] * share);
+		if (n == 0)
+			continue;
+
+		// Bursts go out first, then whatever the rate owes
+		Source &source = mEmitters[i];
+		Emitter &emitter = source.emitter;
+		int from_burst = std::min(n, emitter.burst);
+		emitter.burst -= from_burst;
+		source.owed -= (float)(n - from_burst);
+
+		first[spawns] = mCursor;
+		count[spawns] = n;
+		position[spawns] = emitter.position;
+		velocity[spawns] = emitter.velocity;
+		color[spawns] = emitter.color;
+		shape[spawns] = glm::vec3(emitter.spread, emitter.lifeMin, emitter.lifeMax);
+		mCursor = (mCursor + n) % mCapacity;
+		mLongestLife = std::max(mLongestLife, emitter.lifeMax);
+		spawned += n;
+		spawns++;
+	}
+
+	// One-off emitters are done once their burst is out
+	mEmitters.erase(std::remove_if(mEmitters.begin(), mEmitters.end(), [](const Source &source) {
+		return source.emitter.rate <= 0.0f && source.emitter.burst <= 0;
+	}), mEmitters.end());
+
+	SceneGraph::getStats().particles = spawned;
+
+	// Once everything spawned has outlived its lifetime there is nothing left to simulate or draw
+	mQuiet = spawned > 0 ? 0.0f : mQuiet + dt;
+	if (mQuiet > mLongestLife)
+		return;
+
+	// Simulate: one point per slot, nothing rasterized, every vertex written to the other buffer
+	glUseProgram(mUpdateProgram);
+	glUniform1f(glGetUniformLocation(mUpdateProgram, "delta_time"), dt);
+	glUniform1f(glGetUniformLocation(mUpdateProgram, "time"), mTime);
+	glUniform3fv(glGetUniformLocation(mUpdateProgram, "gravity"), 1, glm::value_ptr(particle_gravity_g));
+	glUniform1i(glGetUniformLocation(mUpdateProgram, "capacity"), mCapacity);
+	glUniform1i(glGetUniformLocation(mUpdateProgram, "spawn_emitters"), spawns);
+	if (spawns > 0) {
+		glUniform1iv(glGetUniformLocation(mUpdateProgram, "spawn_first"), spawns, first);
+		glUniform1iv(glGetUniformLocation(mUpdateProgram, "spawn_count"), spawns, count);
+		glUniform3fv(glGetUniformLocation(mUpdateProgram, "spawn_position"), spawns, glm::value_ptr(position[0]));
+		glUniform3fv(glGetUniformLocation(mUpdateProgram, "spawn_velocity"), spawns, glm::value_ptr(velocity[0]));
+		glUniform3fv(glGetUniformLocation(mUpdateProgram, "spawn_color"), spawns, glm::value_ptr(color[0]));
+		glUniform3fv(glGetUniformLocation(mUpdateProgram, "spawn_shape"), spawns, glm::value_ptr(shape[0]));
+	}
+
+	std::vector<GLint> enabled;
+	bindAttributes(mUpdateProgram, mBuffers[mCurrent], enabled);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mBuffers[1 - mCurrent]);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, mCapacity);
+	glEndTransformFeedback();
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	for (GLint att : enabled) {
+		glDisableVertexAttribArray(att);
+	}
+
+	mCurrent = 1 - mCurrent;
+}
+
+void ParticleSystem::draw(SceneNode *camera, glm::mat4 parentTransf)
+{
+	if (mQuiet > mLongestLife)
+		return;
+
+	// Camera and time come from the frame data, particles are already in world space
+	glUseProgram(mMaterial);
+
+	// Dead particles are dropped by the material, before rasterization
+	std::vector<GLint> enabled;
+	bindAttributes(mMaterial, mBuffers[mCurrent], enabled);
+	glDrawArrays(GL_POINTS, 0, mCapacity);
+
+	for (GLint att : enabled) {
+		glDisableVertexAttribArray(att);
+	}
+}
+
+} // namespace game
@@ -0,0 +1,76 @@
+#ifndef PARTICLE_SYSTEM_H_
+#define PARTICLE_SYSTEM_H_
+
+#include <vector>
+
+#include "scene_node.h"
+
+namespace game {
+
+	// struct Emitter
+	// A source of particles. It spawns 'rate' particles a second for as long as it exists,
+	// plus 'burst' particles on the next update. An emitter with no rate is removed once its burst is out.
+	struct Emitter {
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 velocity = glm::vec3(0.0f);	// Mean velocity of new particles
+		float spread = 1.0f;					// Longest random velocity added to it, in any direction
+		glm::vec3 color = glm::vec3(1.0f);
+		float lifeMin = 1.0f;					// Seconds a particle lives, picked at random in [lifeMin, lifeMax]
+		float lifeMax = 1.0f;
+		float rate = 0.0f;						// Particles per second
+		int burst = 0;							// Particles still to spawn at once
+	};
+
+	// class ParticleSystem
+	// Particles simulated entirely on the GPU. Their state lives in two vertex buffers: every update a vertex-only
+	// program reads one, ages and moves each particle and writes the result to the other with transform feedback.
+	// The CPU only decides which slots are respawned this update and by which emitter, and hands that over as uniforms.
+	// Slots are handed out round-robin, so once the buffer is full the oldest particles are recycled first.
+	// Emitters are static like the SceneGraph lists, so any node can add one without a pointer to the system.
+	class ParticleSystem : public SceneNode {
+
+	public:
+		ParticleSystem(const std::string name, const Resource *updateProgram, const Resource *material, int capacity = 65536);
+		~ParticleSystem();
+
+		// Emitters are addressed by id, ids are never reused
+		static int addEmitter(const Emitter &emitter);
+		static void setEmitterPosition(int id, glm::vec3 position);
+		static void removeEmitter(int id);
+
+		// One-off spray of 'count' particles flying out of 'position' at up to 'speed'
+		static void burst(glm::vec3 position, int count, float speed, glm::vec3 color, float life);
+
+		// Spawn and simulate, at the tick rate
+		virtual void update(double deltaTime);
+		virtual void draw(SceneNode *camera, glm::mat4 parentTransf = glm::mat4(1.0));
+
+		inline int getCapacity() const { return mCapacity; }
+
+	private:
+		struct Source {
+			int id;
+			Emitter emitter;
+			float owed;			// Particles the rate has accumulated but not spawned yet
+		};
+
+		static std::vector<Source> mEmitters;
+		static int mNextEmitterId;
+
+		GLuint mUpdateProgram;
+		GLuint mBuffers[2];		// Particle state, read from mBuffers[mCurrent] and written to the other one
+		int mCurrent;
+		int mCapacity;
+		int mCursor;			// Next slot to respawn
+		float mTime;			// Seeds the random numbers in the update program
+		float mQuiet;			// Seconds since anything was spawned
+		float mLongestLife;		// Longest lifetime handed out so far, once mQuiet passes it every particle is dead
+
+		// Point the update or draw program's particle attributes at a state buffer
+		void bindAttributes(GLuint program, GLuint buffer, std::vector<GLint> &enabled);
+
+	}; // class ParticleSystem
+
+} // namespace game
+
+#endif // PARTICLE_SYSTEM_H_
@@ -19,6 +19,8 @@ namespace game {
 		// Set This as the parentNode of the camera while taking its own parent as his
 		//camera->addChildNode(this);
 		radius = 2;
+		// The saucer bumps into things with its whole hull, projectiles still aim for the radius
+		collisionType = Box;
 	}
 
 	PlayerNode::~PlayerNode() {}
@@ -73,9 +75,6 @@ namespace game {
 		glBindBuffer(GL_ARRAY_BUFFER, mArrayBuffer);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementArrayBuffer);
 
-		// Set globals for camera
-		camera->SetupShader(mMaterial);
-
 		// Set world matrix and other shader input variables
 		SetupShader(mMaterial, parentTransf);
 
@@ -85,14 +84,18 @@ namespace game {
 		}
 		else {
 			glDrawElements(mMode, mSize, GL_UNSIGNED_INT, 0);
+			SceneGraph::getStats().triangles += mSize / 3;
 		}
 
+		// The saucer spins and tilts every frame, so what it carries has to be placed again
 		for (BaseNode* bn : getChildNodes())
 		{
+			bn->markTransformDirty();
 			dynamic_cast<SceneNode*>(bn)->draw(camera, parentTransf);
 		}
 
 		for (BaseNode *bn : weapons) {
+			bn->markTransformDirty();
 			std::string node_name = bn->getName();
 			if (tractor_beam_on && node_name.compare("TRACTORBEAM") == 0) {
 				dynamic_cast<SceneNode*>(bn)->draw(camera, parentTransf);
@@ -157,8 +160,8 @@ void PlayerNode::dropBomb()
 		bombCounter++;
 		for (BaseNode* bn : getChildNodes())
 		{
-			if (bn->hasTag("orbitingHay")) {
-				bn->addTag("delete");
+			if (bn->hasTag("orbitingHay") && !bn->isDestroyed()) {
+				SceneGraph::destroy(bn);
 				break;
 			}
 		}
@@ -240,8 +243,8 @@ void PlayerNode::dropBomb()
 		// Scaling is done only on local object
 		glm::mat4 transf = glm::scale(temp_transf, mScale);
 
-		GLint world_mat = glGetUniformLocation(program, "world_mat");
-		glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(transf));
+		// The ship only turns and moves, so the rotation part is its normal matrix
+		UniformBuffers::SetObject(transf, glm::mat4(glm::mat3(temp_transf)));
 
 		// Texture
 		if (mTexture) {
@@ -270,11 +273,6 @@ void PlayerNode::dropBomb()
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		}
-
-		// Timer
-		GLint timer_var = glGetUniformLocation(program, "timer");
-		double current_time = glfwGetTime();
-		glUniform1f(timer_var, (float)current_time);
 	}
 
 }
\ No newline at end of file
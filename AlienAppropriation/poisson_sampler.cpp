@@ -0,0 +1,150 @@
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POISSON_SSE2 1
+#endif
+
+#include "poisson_sampler.h"
+
+namespace game {
+
+// Candidates land between minDist and 2 * minDist from their point, so with cells minDist / sqrt(2) wide
+// everything that can be closer than minDist to any of them is within this many cells of the point
+const int neighbourhood_cells_g = 5;
+
+// Position of the padding entries in the neighbour list, never close to anything
+const float far_away_g = 1e9f;
+
+
+static inline bool InShape(float x, float y, bool isCircle)
+{
+	if (isCircle) {
+		float fx = x - 0.5f, fy = y - 0.5f;
+		return fx * fx + fy * fy <= 0.25f;
+	}
+	return x >= 0.0f && y >= 0.0f && x <= 1.0f && y <= 1.0f;
+}
+
+// True if any of the first 'count' neighbours (a multiple of 4) is closer than sqrt(minDist2) to (x, y)
+static inline bool HasNeighbour(const float* nx, const float* ny, int count, float x, float y, float minDist2)
+{
+#if POISSON_SSE2
+	const __m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y), limit = _mm_set1_ps(minDist2);
+	for (int i = 0; i < count; i += 4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(nx + i), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(ny + i), py);
+		__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		if (_mm_movemask_ps(_mm_cmplt_ps(d2, limit)))
+			return true;
+	}
+	return false;
+#else
+	for (int i = 0; i < count; i++) {
+		float dx = nx[i] - x, dy = ny[i] - y;
+		if (dx * dx + dy * dy < minDist2)
+			return true;
+	}
+	return false;
+#endif
+}
+
+
+std::vector<glm::vec2> GeneratePoissonPoints(int numPoints, Random& random, int newPointsCount, bool isCircle, float minDist)
+{
+	std::vector<glm::vec2> points;
+	if (numPoints <= 0)
+		return points;
+
+	if (minDist < 0.0f) {
+		minDist = std::sqrt(float(numPoints)) / float(numPoints);
+	}
+	const float minDist2 = minDist * minDist;
+	const float reach2 = 9.0f * minDist2;	// Candidates are at most 2 * minDist from their point
+
+	// Flat background grid, at most one point per cell, -1 for empty
+	const float cellSize = minDist / std::sqrt(2.0f);
+	const int gridSize = (int)std::ceil(1.0f / cellSize);
+	std::vector<int> grid(gridSize * gridSize, -1);
+	auto cellOf = [&](float v) { return std::min(std::max((int)(v / cellSize), 0), gridSize - 1); };
+
+	std::vector<int> active;
+	points.reserve(numPoints);
+
+	// Scratch space: random numbers for one batch of candidates, and the neighbourhood of the current point
+	std::vector<float> batch(2 * newPointsCount);
+	std::vector<float> nx, ny;
+
+	glm::vec2 first;
+	do {
+		first = glm::vec2(random.uniform(), random.uniform());
+	} while (!InShape(first.x, first.y, isCircle));
+
+	points.push_back(first);
+	active.push_back(0);
+	grid[cellOf(first.x) * gridSize + cellOf(first.y)] = 0;
+
+	while (!active.empty() && (int)points.size() < numPoints)
+	{
+		// Take a random active point out of the list
+		int pick = random.range((int)active.size());
+		glm::vec2 p = points[active[pick]];
+		active[pick] = active.back();
+		active.pop_back();
+
+		// Gather the points that could be too close to any candidate
+		int gx = cellOf(p.x), gy = cellOf(p.y);
+		int minX = std::max(gx - neighbourhood_cells_g, 0), maxX = std::min(gx + neighbourhood_cells_g, gridSize - 1);
+		int minY = std::max(gy - neighbourhood_cells_g, 0), maxY = std::min(gy + neighbourhood_cells_g, gridSize - 1);
+		nx.clear();
+		ny.clear();
+		for (int x = minX; x <= maxX; x++) {
+			const int* column = &grid[x * gridSize];
+			for (int y = minY; y <= maxY; y++) {
+				if (column[y] < 0) continue;
+				glm::vec2 q = points[column[y]];
+				if (glm::dot(q - p, q - p) < reach2) {
+					nx.push_back(q.x);
+					ny.push_back(q.y);
+				}
+			}
+		}
+
+		// Followed by three far away entries, so the list can always be read in groups of 4
+		int count = (int)nx.size();
+		nx.resize(count + 3, far_away_g);
+		ny.resize(count + 3, far_away_g);
+
+		random.fillUniform(batch.data(), (int)batch.size());
+		for (int i = 0; i < newPointsCount && (int)points.size() < numPoints; i++)
+		{
+			// Between minDist and 2 * minDist away, in any direction
+			float radius = minDist * (batch[2 * i] + 1.0f);
+			float angle = 2.0f * 3.141592653589f * batch[2 * i + 1];
+			float x = p.x + radius * std::cos(angle);
+			float y = p.y + radius * std::sin(angle);
+
+			if (!InShape(x, y, isCircle))
+				continue;
+
+			if (HasNeighbour(nx.data(), ny.data(), (count + 3) & ~3, x, y, minDist2))
+				continue;
+
+			// Accepted, later candidates of this batch have to keep away from it too
+			int index = (int)points.size();
+			points.push_back(glm::vec2(x, y));
+			active.push_back(index);
+			grid[cellOf(x) * gridSize + cellOf(y)] = index;
+			nx[count] = x;
+			ny[count] = y;
+			count++;
+			nx.push_back(far_away_g);
+			ny.push_back(far_away_g);
+		}
+	}
+
+	return points;
+}
+
+} // namespace game
@@ -0,0 +1,20 @@
+#ifndef POISSON_SAMPLER_H_
+#define POISSON_SAMPLER_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "random.h"
+
+namespace game {
+
+	// Poisson disk points in the unit square (or the circle inscribed in it), with the same arguments and results
+	// as PoissonGenerator::generatePoissonPoints but built for throughput: the background grid is one flat array of
+	// point indices, the active list drops points by swap-remove, and every active point's candidates are generated
+	// in one batch and checked against its neighbourhood four points at a time.
+	// newPointsCount is the number of candidates tried around each point, minDist < 0 picks one from numPoints
+	std::vector<glm::vec2> GeneratePoissonPoints(int numPoints, Random& random, int newPointsCount = 30, bool isCircle = true, float minDist = -1.0f);
+
+} // namespace game
+
+#endif // POISSON_SAMPLER_H_
@@ -3,6 +3,8 @@
 #include "projectile_node.h"
 #include "player_node.h"
 #include "scene_graph.h"
+#include "command_buffer.h"
+#include "particle_system.h"
 
 
 #include <typeinfo>
@@ -12,64 +14,93 @@
 
 namespace game
 {
-ProjectileNode::ProjectileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture /*= NULL*/)
-	: EntityNode(name, geometry, material, texture)
-	, mRemainingLife(lifespan)
-	, mLastTime(glfwGetTime())
+
+// Smoke left behind by heat missiles
+const float trail_rate_g = 40.0f;
+const glm::vec3 trail_color_g(0.6f, 0.6f, 0.6f);
+
+ProjectileNode::ProjectileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture /*= NULL*/, float maxSpeed /*= 0.0f*/)
+	: SceneNode(name, geometry, material, texture)
 {
 	addTag("projectile");
+	mPosition = initialPos;
+	mSlot = ProjectileStore::allocate(this, initialPos, initialVelocityVec, lifespan, maxSpeed, radius);
 }
 
 
 
 ProjectileNode::~ProjectileNode()
 {
-
+	releaseSlot();
 }
 
 void ProjectileNode::update(double deltaTime)
 {
-	EntityNode::update(deltaTime);
-
-	// Check to see if the projectile is still alive, if not destroy it
-	double currentTime = glfwGetTime();
-	if ((currentTime - mLastTime) > 0.05) 
-	{
-		mRemainingLife -= (currentTime - mLastTime);
-		mLastTime = currentTime;
-	}
-
-	if (mRemainingLife <= 0.0f)
-	{
-		addTag("delete");
-	}
+	// Movement, facing and lifetime are handled for all projectiles at once in ProjectileStore::update
+	BaseNode::update(deltaTime);
 }
 
-HeatMissileNode::HeatMissileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture /*= NULL*/)
-	:ProjectileNode(name, geometry, material, lifespan, initialPos, initialVelocityVec, texture)
+glm::vec3 ProjectileNode::getPosition(void)
 {
-	mPosition = initialPos;
-	mVelocity = initialVelocityVec;
-	mMaxVelocity = glm::length(initialVelocityVec);
+	if (mSlot < 0)
+		return mPosition;
+	return ProjectileStore::getPosition(mSlot);
 }
 
-HeatMissileNode::~HeatMissileNode()
+glm::vec3 ProjectileNode::getPreviousPosition(void)
 {
+	if (mSlot < 0)
+		return mPosition;
+	return ProjectileStore::getPreviousPosition(mSlot);
+}
 
+void ProjectileNode::setPosition(glm::vec3 position)
+{
+	if (mSlot < 0)
+		mPosition = position;
+	else
+		ProjectileStore::setPosition(mSlot, position);
+	markTransformDirty();
 }
 
-void HeatMissileNode::update(double deltaTime)
+void ProjectileNode::translate(glm::vec3 trans)
 {
-	ProjectileNode::update(deltaTime);
+	setPosition(getPosition() + trans);
+}
 
-	// Get the player pos
-	glm::vec3 playerPos = SceneGraph::getPlayerNode()->getPosition();
+void ProjectileNode::releaseSlot()
+{
+	if (mSlot < 0)
+		return;
 
-	glm::vec3 dirPlayer = playerPos - mPosition;
-	rotate(dirPlayer);
+	// Keep the last known position on the node itself
+	mPosition = ProjectileStore::getPosition(mSlot);
+	ProjectileStore::release(mSlot);
+	mSlot = -1;
+}
+
+HeatMissileNode::HeatMissileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture /*= NULL*/)
+	:ProjectileNode(name, geometry, material, lifespan, initialPos, initialVelocityVec, texture, glm::length(initialVelocityVec))
+{
+	Emitter trail;
+	trail.position = initialPos;
+	trail.spread = 0.5f;
+	trail.color = trail_color_g;
+	trail.lifeMin = 0.5f;
+	trail.lifeMax = 1.0f;
+	trail.rate = trail_rate_g;
+	mTrail = ParticleSystem::addEmitter(trail);
+}
+
+HeatMissileNode::~HeatMissileNode()
+{
+	ParticleSystem::removeEmitter(mTrail);
+}
 
-	mVelocity += 0.2f * dirPlayer;
-	mVelocity = mMaxVelocity * glm::normalize(mVelocity);
+void HeatMissileNode::update(double deltaTime)
+{
+	ProjectileNode::update(deltaTime);
+	ParticleSystem::setEmitterPosition(mTrail, getPosition());
 }
 
 }
\ No newline at end of file
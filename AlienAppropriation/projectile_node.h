@@ -1,7 +1,8 @@
 #pragma once
 
 
-#include "entity_node.h"
+#include "scene_node.h"
+#include "projectile_store.h"
 
 #include <string.h>
 
@@ -9,17 +10,35 @@
 namespace game
 {
 
-	class ProjectileNode : public EntityNode
+	// class ProjectileNode
+	// A projectile in flight. Like an EntityNode it is a view over a slot, here in the ProjectileStore,
+	// which moves it, ages it and tests it against the player. The node only draws it.
+	class ProjectileNode : public SceneNode
 	{
+		friend class ProjectileStore;
+
 	public:
-		ProjectileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture = nullptr);
+		// 'maxSpeed' above 0 makes the projectile home in on the player
+		ProjectileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture = nullptr, float maxSpeed = 0.0f);
 		~ProjectileNode();
 
 		virtual void update(double deltaTime);
-	
+
+		// Transform overrides, the position is stored in the ProjectileStore
+		virtual glm::vec3 getPosition(void);
+		virtual glm::vec3 getPreviousPosition(void);
+		virtual void setPosition(glm::vec3 position);
+		virtual void translate(glm::vec3 trans);
+
+		inline glm::vec3 getVelocity() { return mSlot < 0 ? glm::vec3(0.0f) : ProjectileStore::getVelocity(mSlot); }
+		inline void setVelocity(glm::vec3 v) { if (mSlot >= 0) ProjectileStore::setVelocity(mSlot, v); }
+
+		// Give the slot back to the store once the node leaves the scene
+		void releaseSlot();
+
 	protected:
-		float mRemainingLife;
-		float mLastTime;
+		// Index of this projectile in the ProjectileStore, -1 once released
+		int mSlot;
 
 	};
 
@@ -30,13 +49,13 @@ namespace game
 		HeatMissileNode(std::string name, const Resource *geometry, const Resource *material, float lifespan, glm::vec3 initialPos, glm::vec3 initialVelocityVec, const Resource *texture = nullptr);
 		~HeatMissileNode();
 
+		// Keeps the smoke trail on the missile
 		virtual void update(double deltaTime);
 	private:
 
-
-		float mMaxVelocity;
+		int mTrail; // Id of the trail's particle emitter
 	};
 
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+
+#include "projectile_store.h"
+#include "projectile_node.h"
+#include "kinematics.h"
+
+namespace game {
+
+// How hard homing projectiles turn towards the player, per tick and per unit of distance
+const float homing_turn_g = 0.2f;
+
+SweepBatch ProjectileStore::mPaths;
+std::vector<float> ProjectileStore::mVelX, ProjectileStore::mVelY, ProjectileStore::mVelZ;
+std::vector<float> ProjectileStore::mLife;
+std::vector<float> ProjectileStore::mMaxSpeed;
+std::vector<float> ProjectileStore::mOrientW, ProjectileStore::mOrientX, ProjectileStore::mOrientY, ProjectileStore::mOrientZ;
+std::vector<ProjectileNode*> ProjectileStore::mOwner;
+std::vector<Contact> ProjectileStore::mContacts;
+
+
+int ProjectileStore::allocate(ProjectileNode* owner, glm::vec3 position, glm::vec3 velocity, float life, float maxSpeed, float radius)
+{
+	mPaths.add(position, position, radius);
+	mVelX.push_back(velocity.x); mVelY.push_back(velocity.y); mVelZ.push_back(velocity.z);
+	mLife.push_back(life);
+	mMaxSpeed.push_back(maxSpeed);
+	mOrientW.push_back(1.0f); mOrientX.push_back(0.0f); mOrientY.push_back(0.0f); mOrientZ.push_back(0.0f);
+	mOwner.push_back(owner);
+	return (int)mOwner.size() - 1;
+}
+
+void ProjectileStore::release(int slot)
+{
+	swapSlots(slot, (int)mOwner.size() - 1);
+
+	mPaths.startX.pop_back(); mPaths.startY.pop_back(); mPaths.startZ.pop_back();
+	mPaths.endX.pop_back(); mPaths.endY.pop_back(); mPaths.endZ.pop_back();
+	mPaths.radius.pop_back();
+	mVelX.pop_back(); mVelY.pop_back(); mVelZ.pop_back();
+	mLife.pop_back();
+	mMaxSpeed.pop_back();
+	mOrientW.pop_back(); mOrientX.pop_back(); mOrientY.pop_back(); mOrientZ.pop_back();
+	mOwner.pop_back();
+}
+
+void ProjectileStore::swapSlots(int a, int b)
+{
+	if (a == b)
+		return;
+
+	std::swap(mPaths.startX[a], mPaths.startX[b]); std::swap(mPaths.startY[a], mPaths.startY[b]); std::swap(mPaths.startZ[a], mPaths.startZ[b]);
+	std::swap(mPaths.endX[a], mPaths.endX[b]); std::swap(mPaths.endY[a], mPaths.endY[b]); std::swap(mPaths.endZ[a], mPaths.endZ[b]);
+	std::swap(mPaths.radius[a], mPaths.radius[b]);
+	std::swap(mVelX[a], mVelX[b]); std::swap(mVelY[a], mVelY[b]); std::swap(mVelZ[a], mVelZ[b]);
+	std::swap(mLife[a], mLife[b]);
+	std::swap(mMaxSpeed[a], mMaxSpeed[b]);
+	std::swap(mOrientW[a], mOrientW[b]); std::swap(mOrientX[a], mOrientX[b]); std::swap(mOrientY[a], mOrientY[b]); std::swap(mOrientZ[a], mOrientZ[b]);
+	std::swap(mOwner[a], mOwner[b]);
+
+	mOwner[a]->mSlot = a;
+	mOwner[b]->mSlot = b;
+}
+
+void ProjectileStore::update(const TickContext& ctx, glm::vec3 playerStart, glm::vec3 playerEnd, float playerRadius,
+	std::vector<ProjectileNode*>& expired, std::vector<ProjectileNode*>& hits)
+{
+	int count = getCount();
+	float dt = (float)ctx.deltaTime;
+
+	SteeringBatch steering;
+	steering.posX = mPaths.endX.data(); steering.posY = mPaths.endY.data(); steering.posZ = mPaths.endZ.data();
+	steering.velX = mVelX.data(); steering.velY = mVelY.data(); steering.velZ = mVelZ.data();
+	steering.maxSpeed = mMaxSpeed.data();
+	steering.orientW = mOrientW.data(); steering.orientX = mOrientX.data(); steering.orientY = mOrientY.data(); steering.orientZ = mOrientZ.data();
+	steering.count = count;
+	steering.targetX = ctx.playerPosition.x; steering.targetY = ctx.playerPosition.y; steering.targetZ = ctx.playerPosition.z;
+	steering.turn = homing_turn_g;
+	SteerProjectiles(steering);
+
+	// Hand the new facing to the nodes now, they are drawn after this and would otherwise lag a tick behind
+	for (int i = 0; i < count; i++)
+	{
+		mOwner[i]->setOrientation(getOrientation(i));
+	}
+
+	// Move, never into the ground, and age
+	for (int i = 0; i < count; i++)
+	{
+		mPaths.startX[i] = mPaths.endX[i];
+		mPaths.startY[i] = mPaths.endY[i];
+		mPaths.startZ[i] = mPaths.endZ[i];
+		mPaths.endX[i] += mVelX[i];
+		mPaths.endY[i] = std::max(mPaths.endY[i] + mVelY[i], 0.0f);
+		mPaths.endZ[i] += mVelZ[i];
+		mLife[i] -= dt;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (mLife[i] <= 0.0f)
+			expired.push_back(mOwner[i]);
+	}
+
+	// Everything against the player in one batch, straight from the position arrays
+	mContacts.clear();
+	SweepBatchSphere(mPaths, playerStart, playerEnd, playerRadius, mContacts);
+	for (const Contact& contact : mContacts)
+	{
+		hits.push_back(mOwner[contact.index]);
+	}
+}
+
+} // namespace game
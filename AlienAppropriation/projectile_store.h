@@ -0,0 +1,71 @@
+#ifndef PROJECTILE_STORE_H_
+#define PROJECTILE_STORE_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "tick_context.h"
+#include "collision.h"
+
+namespace game {
+
+	class ProjectileNode;
+
+	// class ProjectileStore
+	// Structure-of-arrays storage for every live projectile, like the EntityStore is for entities
+	// Projectiles are not in the collision grid: steering, movement, expiry and the hit test against
+	// the player all run over these arrays, so their cost follows the number of projectiles in flight
+	// and not the size of the world. Slots are kept dense by moving the last projectile into a hole.
+	// Main thread only.
+	class ProjectileStore {
+
+	public:
+		// 'maxSpeed' above 0 makes a homing projectile, steered at the player at that speed
+		static int allocate(ProjectileNode* owner, glm::vec3 position, glm::vec3 velocity, float life, float maxSpeed, float radius);
+		static void release(int slot);
+
+		// Steer every projectile against the player position of 'ctx', taken once for the tick, then move and age
+		// them all and sweep them all against the player, who moved from
+		// 'playerStart' to 'playerEnd' this tick.
+		// Projectiles out of life go to 'expired', those that hit the
+		// player to 'hits' in the order they hit. One projectile can show up in both
+		static void update(const TickContext& ctx, glm::vec3 playerStart, glm::vec3 playerEnd, float playerRadius,
+			std::vector<ProjectileNode*>& expired, std::vector<ProjectileNode*>& hits);
+
+		inline static int getCount() { return (int)mOwner.size(); }
+		inline static ProjectileNode* getOwner(int slot) { return mOwner[slot]; }
+
+		inline static glm::vec3 getPosition(int slot) { return glm::vec3(mPaths.endX[slot], mPaths.endY[slot], mPaths.endZ[slot]); }
+		inline static glm::vec3 getPreviousPosition(int slot) { return glm::vec3(mPaths.startX[slot], mPaths.startY[slot], mPaths.startZ[slot]); }
+		// A teleport, like EntityStore::setPosition
+		inline static void setPosition(int slot, glm::vec3 p)
+		{
+			mPaths.startX[slot] = mPaths.endX[slot] = p.x;
+			mPaths.startY[slot] = mPaths.endY[slot] = p.y;
+			mPaths.startZ[slot] = mPaths.endZ[slot] = p.z;
+		}
+		inline static glm::vec3 getVelocity(int slot) { return glm::vec3(mVelX[slot], mVelY[slot], mVelZ[slot]); }
+		inline static void setVelocity(int slot, glm::vec3 v) { mVelX[slot] = v.x; mVelY[slot] = v.y; mVelZ[slot] = v.z; }
+		// Facing along the velocity, worked out by update, which also hands it to the owning node
+		inline static glm::quat getOrientation(int slot) { return glm::quat(mOrientW[slot], mOrientX[slot], mOrientY[slot], mOrientZ[slot]); }
+
+	private:
+		// Where each projectile was at the start of the tick and is now, with its radius
+		// Laid out as a SweepBatch so the hit test reads the positions in place
+		static SweepBatch mPaths;
+		static std::vector<float> mVelX, mVelY, mVelZ;
+		static std::vector<float> mLife;		// Seconds of game time left
+		static std::vector<float> mMaxSpeed;	// 0 for projectiles flying straight
+		static std::vector<float> mOrientW, mOrientX, mOrientY, mOrientZ;
+		static std::vector<ProjectileNode*> mOwner;
+
+		static std::vector<Contact> mContacts;
+
+		static void swapSlots(int a, int b);
+
+	}; // class ProjectileStore
+
+} // namespace game
+
+#endif // PROJECTILE_STORE_H_
@@ -0,0 +1,85 @@
+#include "random.h"
+
+namespace game {
+
+uint32_t Random::mGlobalSeed = 0x9E3779B9u;
+uint32_t Random::mStreamCounter = 0;
+
+// splitmix32, used to expand one seed into well mixed generator state
+static uint32_t SplitMix32(uint32_t& x)
+{
+	uint32_t z = (x += 0x9E3779B9u);
+	z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+	z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+	return z ^ (z >> 16);
+}
+
+
+void Random::setGlobalSeed(uint32_t seed)
+{
+	mGlobalSeed = seed;
+	mStreamCounter = 0;
+}
+
+Random::Random()
+{
+	// Streams are only handed out on the main thread (nodes are created there)
+	seed(mGlobalSeed ^ (0x632BE5ABu * ++mStreamCounter));
+}
+
+Random::Random(uint32_t seed)
+{
+	this->seed(seed);
+}
+
+void Random::seed(uint32_t seed)
+{
+	uint32_t x = seed;
+	for (int lane = 0; lane < 4; lane++) {
+		mS0[lane] = SplitMix32(x);
+		mS1[lane] = SplitMix32(x);
+		mS2[lane] = SplitMix32(x);
+		mS3[lane] = SplitMix32(x);
+	}
+	mCursor = 4;
+}
+
+void Random::next4(float out[4])
+{
+	// Straight-line per-lane loops with no cross-lane dependencies vectorize well
+	for (int lane = 0; lane < 4; lane++) {
+		uint32_t result = mS0[lane] + mS3[lane];
+		uint32_t t = mS1[lane] << 9;
+
+		mS2[lane] ^= mS0[lane];
+		mS3[lane] ^= mS1[lane];
+		mS1[lane] ^= mS2[lane];
+		mS0[lane] ^= mS3[lane];
+		mS2[lane] ^= t;
+		mS3[lane] = (mS3[lane] << 11) | (mS3[lane] >> 21);
+
+		// Top 24 bits give every float in [0, 1) with a 2^-24 step
+		out[lane] = (float)(result >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+void Random::refill()
+{
+	next4(mBuffer);
+	mCursor = 0;
+}
+
+void Random::fillUniform(float* out, int count, float min, float max)
+{
+	float scale = max - min;
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		next4(out + i);
+		for (int lane = 0; lane < 4; lane++)
+			out[i + lane] = min + scale * out[i + lane];
+	}
+	for (; i < count; i++)
+		out[i] = uniform(min, max);
+}
+
+} // namespace game
@@ -0,0 +1,59 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+
+namespace game {
+
+	// class Random
+	// Small, lock-free random number generator meant to be owned by a single entity (or thread)
+	// Runs four xoshiro128+ streams side by side in structure-of-arrays form, so refilling
+	// four numbers at once is a plain loop the compiler can turn into SSE/NEON integer ops
+	class Random {
+
+	public:
+		// Every Random created after this gets a different stream derived from the seed
+		static void setGlobalSeed(uint32_t seed);
+
+		// Take the next stream from the global seed
+		Random();
+		explicit Random(uint32_t seed);
+
+		// Uniform float in [0, 1)
+		inline float uniform()
+		{
+			if (mCursor == 4) refill();
+			return mBuffer[mCursor++];
+		}
+
+		// Uniform float in [min, max)
+		inline float uniform(float min, float max) { return min + (max - min) * uniform(); }
+
+		// Uniform integer in [0, n)
+		inline int range(int n) { return (int)(uniform() * n); }
+
+		// Fill 'out' with uniform floats in [min, max)
+		void fillUniform(float* out, int count, float min = 0.0f, float max = 1.0f);
+
+	private:
+		// xoshiro128+ state, one column per stream
+		uint32_t mS0[4], mS1[4], mS2[4], mS3[4];
+
+		// Floats generated by the last refill
+		float mBuffer[4];
+		int mCursor;
+
+		void seed(uint32_t seed);
+
+		// Advance all four streams and convert their outputs to floats in [0, 1)
+		void next4(float out[4]);
+		void refill();
+
+		static uint32_t mGlobalSeed;
+		static uint32_t mStreamCounter;
+
+	}; // class Random
+
+} // namespace game
+
+#endif // RANDOM_H_
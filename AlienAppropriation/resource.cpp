@@ -9,6 +9,8 @@ Resource::Resource(ResourceType type, std::string name, GLuint resource, GLsizei
     mName = name;
     mResource = resource;
     mSize = size;
+    mBoundingRadius = 0.0f;
+    mBoundsMin = mBoundsMax = glm::vec3(0.0f);
 }
 
 
@@ -18,6 +20,8 @@ Resource::Resource(ResourceType type, std::string name, GLuint array_buffer, GLu
     mArrayBuffer = array_buffer;
     mElementArrayBuffer = element_array_buffer;
     mSize = size;
+    mBoundingRadius = 0.0f;
+    mBoundsMin = mBoundsMax = glm::vec3(0.0f);
 }
 
 
@@ -61,4 +65,11 @@ GLsizei Resource::getSize(void) const {
     return mSize;
 }
 
+
+void Resource::addLod(GLuint array_buffer, GLuint element_array_buffer, GLsizei size){
+
+    Lod lod = { array_buffer, element_array_buffer, size };
+    mLods.push_back(lod);
+}
+
 } // namespace game
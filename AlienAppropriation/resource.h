@@ -2,9 +2,11 @@
 #define RESOURCE_H_
 
 #include <string>
+#include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 
 namespace game {
 
@@ -28,6 +30,19 @@ namespace game {
             };
             GLsizei mSize; // Number of primitives in geometry
 
+        public:
+            // A simplified version of a mesh
+            struct Lod {
+                GLuint mArrayBuffer;
+                GLuint mElementArrayBuffer;
+                GLsizei mSize;
+            };
+
+        private:
+            std::vector<Lod> mLods; // Levels of detail after the full mesh, coarsest last
+            float mBoundingRadius; // Distance of the furthest vertex from the mesh origin
+            glm::vec3 mBoundsMin, mBoundsMax; // Axis-aligned box around the vertices, in mesh space
+
         public:
             Resource(ResourceType type, std::string name, GLuint resource, GLsizei size);
             Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
@@ -39,6 +54,17 @@ namespace game {
             GLuint getElementArrayBuffer(void) const;
             GLsizei getSize(void) const;
 
+            // Levels of detail
+            void addLod(GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            inline const std::vector<Lod>& getLods(void) const { return mLods; }
+            inline float getBoundingRadius(void) const { return mBoundingRadius; }
+            inline void setBoundingRadius(float radius) { mBoundingRadius = radius; }
+            inline glm::vec3 getBoundsMin(void) const { return mBoundsMin; }
+            inline glm::vec3 getBoundsMax(void) const { return mBoundsMax; }
+            // Only meshes loaded from a file are measured
+            inline bool hasBounds(void) const { return mBoundsMin != mBoundsMax; }
+            inline void setBounds(glm::vec3 min, glm::vec3 max) { mBoundsMin = min; mBoundsMax = max; }
+
     }; // class Resource
 
 } // namespace game
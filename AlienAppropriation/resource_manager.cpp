@@ -4,15 +4,25 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 #include <SOIL/SOIL.h>
 
 #include "resource_manager.h"
 #include "model_loader.h"
+#include "mesh_simplify.h"
+#include "random.h"
+#include "uniform_buffers.h"
 
 namespace game {
 
+// Meshes with at least this many triangles get simplified levels of detail
+const unsigned int lod_min_faces_g = 256;
+// Triangle count of each level of detail, relative to the full mesh
+const float lod_ratios_g[] = { 0.5f, 0.2f, 0.08f };
+
 std::vector<Resource*> ResourceManager::mResource;
+std::unordered_map<std::string, Resource*> ResourceManager::mResourceIndex;
 
 ResourceManager::ResourceManager(void){
 }
@@ -29,6 +39,7 @@ void ResourceManager::AddResource(ResourceType type, const std::string name, GLu
     res = new Resource(type, name, resource, size);
 
     mResource.push_back(res);
+    mResourceIndex.insert(std::make_pair(name, res));
 }
 
 
@@ -39,6 +50,7 @@ void ResourceManager::AddResource(ResourceType type, const std::string name, GLu
     res = new Resource(type, name, array_buffer, element_array_buffer, size);
 
     mResource.push_back(res);
+    mResourceIndex.insert(std::make_pair(name, res));
 }
 
 
@@ -64,11 +76,10 @@ void ResourceManager::LoadResource(ResourceType type, const std::string name, co
 
 Resource *ResourceManager::getResource(const std::string name) {
 
-    // Find resource with the specified name
-    for (int i = 0; i < mResource.size(); i++){
-        if (mResource[i]->getName() == name){
-            return mResource[i];
-        }
+    // Find resource with the specified name, the first one added wins
+    std::unordered_map<std::string, Resource*>::const_iterator it = mResourceIndex.find(name);
+    if (it != mResourceIndex.end()){
+        return it->second;
     }
     return NULL;
 }
@@ -160,6 +171,9 @@ void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
         throw(std::ios_base::failure(std::string("Error linking shaders: ")+std::string(buffer)));
     }
 
+    // Camera, lights and matrices come from the shared uniform buffers
+    UniformBuffers::BindProgram(sp);
+
     // Delete memory used by shaders, since they were already compiled
     // and linked
     glDeleteShader(vs);
@@ -173,6 +187,47 @@ void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
 }
 
 
+void ResourceManager::LoadFeedbackProgram(const std::string name, const char *prefix, const std::vector<const char*> &varyings){
+
+    // Load vertex program source code, there is nothing to rasterize so no other stage
+    std::string filename = std::string(prefix) + std::string(VERTEX_PROGRAM_EXTENSION);
+    std::string vp = LoadTextFile(filename.c_str());
+
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    const char *source_vp = vp.c_str();
+    glShaderSource(vs, 1, &source_vp, NULL);
+    glCompileShader(vs);
+
+    // Check if shader compiled successfully
+    GLint status;
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE){
+        char buffer[512];
+        glGetShaderInfoLog(vs, 512, NULL, buffer);
+        throw(std::ios_base::failure(std::string("Error compiling vertex shader: ")+std::string(buffer)));
+    }
+
+    // The captured outputs have to be declared before linking
+    GLuint sp = glCreateProgram();
+    glAttachShader(sp, vs);
+    glTransformFeedbackVaryings(sp, (GLsizei)varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(sp);
+
+    // Check if the program was linked successfully
+    glGetProgramiv(sp, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE){
+        char buffer[512];
+        glGetProgramInfoLog(sp, 512, NULL, buffer);
+        throw(std::ios_base::failure(std::string("Error linking feedback program: ")+std::string(buffer)));
+    }
+
+    glDeleteShader(vs);
+
+    // Add a resource for the shader program
+    AddResource(Material, name, sp, 0);
+}
+
+
 std::string ResourceManager::LoadTextFile(const char *filename){
 
     // Open file
@@ -615,6 +670,39 @@ void ResourceManager::LoadMesh(const std::string name, const char *filename) {
 	// If we got to this point, the file was parsed successfully and the
 	// mesh is in memory
 	// Now, transfer the mesh to OpenGL buffers
+	GLuint vbo, ebo;
+	GLsizei size = UploadMesh(mesh, added_normal, vbo, ebo);
+	AddResource(Mesh, name, vbo, ebo, size);
+	Resource *res = mResource.back();
+
+	float radius = 0.0f;
+	glm::vec3 min(0.0f), max(0.0f);
+	if (!mesh.position.empty()) {
+		min = max = mesh.position[0];
+	}
+	for (const glm::vec3& p : mesh.position) {
+		radius = std::max(radius, glm::length(p));
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	res->setBoundingRadius(radius);
+	res->setBounds(min, max);
+
+	// Detailed meshes get a chain of simplified versions for drawing at a distance
+	// Each level is simplified from the previous one, which is much faster than starting over every time
+	if (mesh.face.size() >= lod_min_faces_g) {
+		TriMesh lod = mesh;
+		for (float ratio : lod_ratios_g) {
+			lod = SimplifyMesh(lod, (int)(mesh.face.size() * ratio));
+			size = UploadMesh(lod, added_normal, vbo, ebo);
+			res->addLod(vbo, ebo, size);
+		}
+	}
+}
+
+
+GLsizei ResourceManager::UploadMesh(const TriMesh &mesh, bool added_normal, GLuint &vbo, GLuint &ebo) {
+
 	// Create three new vertices for each face, in case vertex
 	// normals/texture coordinates are not consistent over the mesh
 
@@ -622,21 +710,14 @@ void ResourceManager::LoadMesh(const std::string name, const char *filename) {
 	const int vertex_att = 11;
 	const int face_att = 3;
 
-	// Create OpenGL buffers and copy data
-	GLuint vbo, ebo;
-
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, mesh.face.size() * 3 * vertex_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
-
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.face.size() * face_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
+	// Build the whole buffers in memory, then copy them over in one go
+	std::vector<GLfloat> vertex(mesh.face.size() * 3 * vertex_att, 0.0f);
+	std::vector<GLuint> face(mesh.face.size() * face_att);
 
 	unsigned int vertex_index = 0;
 	for (unsigned int i = 0; i < mesh.face.size(); i++) {
 		// Add three vertices and their attributes
-		GLfloat att[3 * vertex_att] = { 0 };
+		GLfloat *att = &vertex[i * 3 * vertex_att];
 		for (int j = 0; j < 3; j++) {
 			// Position
 			att[j*vertex_att + 0] = mesh.position[mesh.face[i].i[j]][0];
@@ -663,22 +744,23 @@ void ResourceManager::LoadMesh(const std::string name, const char *filename) {
 			}
 		}
 
-		// Copy attributes to buffer
-		glBufferSubData(GL_ARRAY_BUFFER, i * 3 * vertex_att * sizeof(GLfloat), 3 * vertex_att * sizeof(GLfloat), att);
-
 		// Add triangle
-		GLuint findex[face_att] = { 0 };
-		findex[0] = vertex_index;
-		findex[1] = vertex_index + 1;
-		findex[2] = vertex_index + 2;
+		face[i * face_att + 0] = vertex_index;
+		face[i * face_att + 1] = vertex_index + 1;
+		face[i * face_att + 2] = vertex_index + 2;
 		vertex_index += 3;
-
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, i * face_att * sizeof(GLuint), face_att * sizeof(GLuint), findex);
 	}
 
-	// Create resource
-	AddResource(Mesh, name, vbo, ebo, mesh.face.size() * face_att);
+	// Create OpenGL buffers and copy data
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertex.size() * sizeof(GLfloat), vertex.data(), GL_STATIC_DRAW);
 
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, face.size() * sizeof(GLuint), face.data(), GL_STATIC_DRAW);
+
+	return (GLsizei)face.size();
 }
 
 void ResourceManager::CreateCylinder(std::string object_name, float radius, int resolution, glm::vec3 color) {
@@ -997,123 +1079,6 @@ void ResourceManager::CreateSquare(std::string object_name, float width, glm::ve
 	AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
 }
 
-void ResourceManager::CreateGrid(std::string object_name, float heightVariance, int width, int height, float tileSize)
-{
-	// Create a plane built from a grid of many triangles
-
-	// Number of vertices and faces to be created
-	const GLuint vertex_num = width * height;
-	const GLuint face_num = (width - 1) * (height - 1) * 2;
-
-	// Number of attributes for vertices and faces
-	const int vertex_att = 11;  // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
-	const int face_att = 3; // Vertex indices (3)
-
-	GLfloat *vertex = NULL;
-	GLuint *face = NULL;
-
-	// Allocate memory for buffers
-	try {
-		vertex = new GLfloat[vertex_num * vertex_att];
-		face = new GLuint[face_num * face_att];
-	}
-	catch (std::exception &e) {
-		throw e;
-	}
-
-	std::vector<std::vector<float>> heightMap;
-
-	for (int x = 0; x < width; x++) {
-		std::vector<float> column;
-		for (int y = 0; y < height; y++) {
-			column.push_back(heightVariance * (rand() % 2 - 1));
-		}
-		heightMap.push_back(column);
-
-	}
-
-
-	// Create vertices 
-	glm::vec3 vertex_position;
-	glm::vec3 vertex_normal;
-	glm::vec3 vertex_color;
-	glm::vec2 vertex_coord;
-
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-
-			// Define position, normal and color of vertex
-			vertex_normal = glm::vec3(0, 1, 0);
-			vertex_position = glm::vec3(x * tileSize, heightMap.at(x).at(y), y * tileSize);
-
-			vertex_color = glm::vec3(
-				(float)x / (float)width,
-				0,
-				(float)y / (float)height);
-
-
-
-			vertex_coord = glm::vec2(x, y);
-			// Add vectors to the data buffer
-			for (int k = 0; k < 3; k++) {
-				vertex[(x * height + y)*vertex_att + k] = vertex_position[k];
-				vertex[(x * height + y)*vertex_att + k + 3] = vertex_normal[k];
-				vertex[(x * height + y)*vertex_att + k + 6] = vertex_color[k];
-			}
-			vertex[(x * height + y)*vertex_att + 9] = vertex_coord[0];
-			vertex[(x * height + y)*vertex_att + 10] = vertex_coord[1];
-		}
-	}
-
-
-
-
-
-		// Create triangles
-		for (int x = 0; x < width - 1; x++) {
-			for (int y = 0; y < height - 1; y++) {
-				//Each grid square is composed of two triangles
-				glm::vec3 t1(
-					(x * width) + y,
-					(x * width) + y + 1,
-					((x + 1) * width) + y
-				);
-				glm::vec3 t2(
-					(x * width) + y + 1,
-					((x + 1) * width) + y + 1,
-					((x + 1) * width) + y
-				);
-				// Add the two triangles to the data buffer
-				for (int k = 0; k < 3; k++) {
-					face[(x * (2 * (height - 1)) + 2 * y)*face_att + k] = (GLuint)t1[k];
-					face[(x * (2 * (height - 1)) + 2 * y + 1)*face_att + k] = (GLuint)t2[k];
-
-				}
-
-			}
-		}
-
-
-		// Create model 
-		// Create OpenGL buffer for vertices
-		GLuint vbo, ebo;
-		glGenBuffers(1, &vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-		// Create OpenGL buffer for faces
-		glGenBuffers(1, &ebo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
-
-		// Free data buffers
-		delete[] vertex;
-		delete[] face;
-
-		// Create resource
-		AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
-}
-
 void ResourceManager::CreateSphereParticles(std::string object_name, int num_particles) {
 
 	// Create a set of points which will be the particles
@@ -1136,13 +1101,14 @@ void ResourceManager::CreateSphereParticles(std::string object_name, int num_par
 	float trad = 0.2; // Defines the starting point of the particles along the normal
 	float maxspray = 0.5; // This is how much we allow the points to deviate from the sphere
 	float u, v, w, theta, phi, spray; // Work variables
+	Random random;
 
 	for (int i = 0; i < num_particles; i++) {
 
 		// Get three random numbers
-		u = ((double)rand() / (RAND_MAX));
-		v = ((double)rand() / (RAND_MAX));
-		w = ((double)rand() / (RAND_MAX));
+		u = random.uniform();
+		v = random.uniform();
+		w = random.uniform();
 
 		// Use u to define the angle theta along one direction of the sphere
 		theta = u * 2.0*glm::pi<float>();
@@ -1332,14 +1298,15 @@ void ResourceManager::CreateTorusParticles(std::string object_name, int num_part
 
 	float maxspray = 0.5; // This is how much we allow the points to deviate from the sphere
 	float u, v, w, theta, phi, spray; // Work variables
+	Random random;
 
 	for (int i = 0; i < num_particles; i++) {
 
 		// Get a random point on a torus
 
 		// Get two random numbers
-		u = ((double)rand() / (RAND_MAX));
-		v = ((double)rand() / (RAND_MAX));
+		u = random.uniform();
+		v = random.uniform();
 
 		// Use u to define the angle theta along the loop of the torus
 		theta = u * 2.0*glm::pi<float>();
@@ -1354,9 +1321,9 @@ void ResourceManager::CreateTorusParticles(std::string object_name, int num_part
 
 																						  // Now sample a point on a sphere to define a direction for points to wander around
 																						  // Get three random numbers
-		u = ((double)rand() / (RAND_MAX));
-		v = ((double)rand() / (RAND_MAX));
-		w = ((double)rand() / (RAND_MAX));
+		u = random.uniform();
+		v = random.uniform();
+		w = random.uniform();
 
 		// Use u to define the angle theta along one direction of the sphere
 		theta = u * 2.0*glm::pi<float>();
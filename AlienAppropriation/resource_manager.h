@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -18,6 +19,8 @@
 
 namespace game {
 
+    struct TriMesh;
+
     // Class that manages all resources
     class ResourceManager {
 
@@ -32,6 +35,8 @@ namespace game {
             void LoadResource(ResourceType type, const std::string name, const char *filename);
             // Get the resource with the specified name
             static Resource *getResource(const std::string name);
+            // Load a vertex-only program whose outputs are captured with transform feedback, 'varyings' in buffer order
+            void LoadFeedbackProgram(const std::string name, const char *prefix, const std::vector<const char*> &varyings);
 
             // Methods to create specific resources
             // Create the geometry for a torus and add it to the list of resources
@@ -44,8 +49,6 @@ namespace game {
 			void CreateCone(std::string object_name, float radius = 0.6, int resolution = 30);
 			// Create the geometry of a plane using two triangles
 			void CreateSquare(std::string object_name, float width = 1.0, glm::vec3 color = glm::vec3(1.0f));
-			// Create the geometry of a plane using a grid
-			void CreateGrid(std::string object_name, float heightVariance= 0, int width = 11, int height = 11, float tileSize = 10.0);
 			// Create particles distributed over a sphere
 			void CreateSphereParticles(std::string object_name, int num_particles = 20000);
 			void CreateParticles_Point(std::string object_name, int num_particles = 3000);
@@ -57,6 +60,8 @@ namespace game {
 	private:
             // List storing all resources
             static std::vector<Resource*> mResource; 
+            // The same resources by name, for getResource
+            static std::unordered_map<std::string, Resource*> mResourceIndex;
  
             // Methods to load specific types of resources
             // Load shaders programs
@@ -67,6 +72,8 @@ namespace game {
 			void LoadTexture(const std::string name, const char *filename);
 			// Loads a mesh in obj format
 			void LoadMesh(const std::string name, const char *filename);
+			// Copy a mesh to new OpenGL buffers, returns the number of indices
+			GLsizei UploadMesh(const TriMesh &mesh, bool added_normal, GLuint &vbo, GLuint &ebo);
 			void LoadCubeMap(const std::string name, const char *filename);
 
     }; // class ResourceManager
@@ -1,6 +1,8 @@
 #include <stdexcept>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -9,21 +11,46 @@
 #include "scene_graph.h"
 
 #include "scene_node.h"
+#include "command_buffer.h"
+#include "timer_queue.h"
 
 namespace game {
 
+// Entities handed to each job in the parallel update phase
+const int think_grain_g = 256;
+
+// Idle entities further than the sleep radius from the player go to sleep, sleepers closer than the wake radius wake up
+// The sleep radius is past the farmers' 70 unit sight range, the gap between the two stops entities flickering at the edge
+const float sleep_radius_g = 80.0f;
+const float wake_radius_g = 75.0f;
+
 BaseNode* SceneGraph::mRootNode = nullptr;
 PlayerNode* SceneGraph::mPlayerNode = nullptr;
-std::vector<std::vector<std::vector<SceneNode*>>> SceneGraph::nodes(15, std::vector<std::vector<SceneNode*>>(15, std::vector<SceneNode*>()));
+Stats SceneGraph::mStats;
+std::vector<BaseNode*> SceneGraph::mDestroyQueue;
+glm::vec3 SceneGraph::mLastPlayerPosition(0.0f);
+std::vector<std::vector<std::vector<SceneNode*>>> SceneGraph::nodes(grid_cells_g, std::vector<std::vector<SceneNode*>>(grid_cells_g, std::vector<SceneNode*>()));
 
-SceneGraph::SceneGraph(Camera* camera) {
+SceneGraph::SceneGraph(Camera* camera)
+	: mBroadphase(grid_cells_g, grid_cell_size_g)
+{
 
     mBackgroundColor = glm::vec3(0.0, 0.0, 0.0);
 
+	// Sun light, what the lit materials had built in
+	mFrame = FrameUniforms();
+	mFrame.lightDirection = glm::vec4(-1.0f, -0.7f, -1.0f, 0.0f);
+	mFrame.lightAmbient = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	mFrame.lightDiffuse = glm::vec4(0.6f, 0.6f, 0.6f, 1.0f);
+	mFrame.lightSpecular = glm::vec4(0.7f, 0.7f, 0.7f, 1.0f);
+	mFrame.ambientAmount = 0.4f;
+
 	mRootNode = new BaseNode("ROOT");
 	addNode(camera);
 	mCameraNode = camera;
 
+	mJobSystem = new JobSystem();
+
 
 }
 
@@ -32,6 +59,7 @@ SceneGraph::SceneGraph(Camera* camera) {
 //std::vector<SceneNode*> SceneGraph::nodes;
 
 SceneGraph::~SceneGraph(){
+	delete mJobSystem;
 }
 
 
@@ -47,15 +75,71 @@ glm::vec3 SceneGraph::GetBackgroundColor(void) const {
 }
 
 
-void SceneGraph::deleteNode(BaseNode * node)
+void SceneGraph::destroy(BaseNode * node)
+{
+	if (node->mDestroyed)
+		return;
+	node->mDestroyed = true;
+	mDestroyQueue.push_back(node);
+}
+
+void SceneGraph::unlink(BaseNode * node)
 {
-	node->getParentNode()->removeChildNode(node);
+	// Entities stop being simulated as soon as they leave the scene
+	if (EntityNode* entity = dynamic_cast<EntityNode*>(node)) {
+		entity->releaseSlot();
+	}
+	else if (ProjectileNode* projectile = dynamic_cast<ProjectileNode*>(node)) {
+		projectile->releaseSlot();
+	}
+	if (SceneNode* scn = dynamic_cast<SceneNode*>(node)) {
+		gridRemove(scn);
+	}
+
+	if (node->getParentNode())
+		node->getParentNode()->removeChildNode(node);
 	for (BaseNode* child : node->getChildNodes()) {
-		child->setParentNode(nullptr);
-		child->addTag("delete");
+		destroy(child);
 	}
 }
 
+void SceneGraph::flushDestroyed()
+{
+	// Unlink everything first, destroying a node queues its children behind it
+	for (int i = 0; i < mDestroyQueue.size(); i++) {
+		unlink(mDestroyQueue.at(i));
+	}
+
+	// Back to the node pools, handles to these nodes go stale
+	for (BaseNode* node : mDestroyQueue) {
+		delete node;
+	}
+	mDestroyQueue.clear();
+}
+
+void SceneGraph::gridInsert(SceneNode * node, int x, int y)
+{
+	std::vector<SceneNode*>& cell = nodes.at(x).at(y);
+	node->mCell = glm::ivec2(x, y);
+	node->mCellIndex = (int)cell.size();
+	cell.push_back(node);
+}
+
+void SceneGraph::gridRemove(SceneNode * node)
+{
+	if (node->mCellIndex < 0)
+		return;
+
+	// Swap with the last node of the cell
+	std::vector<SceneNode*>& cell = nodes.at(node->mCell.x).at(node->mCell.y);
+	SceneNode* last = cell.back();
+	cell.at(node->mCellIndex) = last;
+	last->mCellIndex = node->mCellIndex;
+	cell.pop_back();
+
+	node->mCellIndex = -1;
+}
+
 void SceneGraph::deleteNode(std::string name)
 {
 	for (std::vector<std::vector<SceneNode*>> column : nodes) {
@@ -64,7 +148,7 @@ void SceneGraph::deleteNode(std::string name)
 			{
 				if (name.compare(n->getName()) == 0)
 				{
-					deleteNode(n);
+					destroy(n);
 					return;
 				}
 			}
@@ -101,6 +185,12 @@ void SceneGraph::draw(Camera *camera)
                  mBackgroundColor[2], 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	mStats.triangles = 0;
+
+	// Camera, time and lights go up once, every program reads them from the same buffer
+	camera->SetupFrame(mFrame);
+	UniformBuffers::SetFrame(mFrame);
+
 	for (BaseNode* bn : mRootNode->getChildNodes())
 	{
 		dynamic_cast<SceneNode*>(bn)->draw(camera);
@@ -108,8 +198,8 @@ void SceneGraph::draw(Camera *camera)
 }
 
 // Check for collision
-// If return true, then the object will be deleted (used for projectiles, cows)
-bool SceneGraph::checkCollisionWithPlayer(SceneNode * object)
+// Pickups are decided right away, anything touching the player's hull is queued for the narrowphase
+void SceneGraph::checkCollisionWithPlayer(SceneNode * object)
 {
 
 	// Check if any objects below the player can be sucked up
@@ -128,59 +218,163 @@ bool SceneGraph::checkCollisionWithPlayer(SceneNode * object)
 	}
 
 	// Check for any other collision
-	if (object->getCollisionType() == Point) {
-		if ((glm::distance(object->getPosition(), mPlayerNode->getPosition())) < object->getRadius() + mPlayerNode->getRadius()) {
-			
-			
-			// Check if any objects can be collected
-			if (object->hasTag("canCollect")) {
-				if (mPlayerNode->isTractorBeamActive() && (glm::distance(object->getPosition(), mPlayerNode->getPosition())) < object->getRadius() + mPlayerNode->getRadius()) {
-					object->addTag("delete");
-					if (object->hasTag("bull")) {
-						mPlayerNode->takeDamage(BULL);
-					}
-					else if (object->hasTag("cow")) {
-						mPlayerNode->addHealth(5);
-					}
-					mPlayerNode->addCollected( object->hasTag("cow") ? "cow" : "hay" );
-					return true;
-				}
-			}
-			
-			
-			
-			ProjectileNode* proj = dynamic_cast<ProjectileNode*> (object);
-			if (proj) {
-				proj->addTag("delete");
-				if (!mPlayerNode->isShieldActive()) {
-					mPlayerNode->takeDamage(MISSILE);
-				}
-				else {
-					mPlayerNode->addEnergy(-25.0f);
-				}
-				return true;
-			}
-			else {
-				mCameraNode->setVelocity(glm::vec3(0));
-			}
+	if (object->getCollisionType() != None) {
+		mNarrowphase.add(mPlayerShape, object->getCollisionShape(), (int)mNearPlayer.size());
+		mNearPlayer.push_back(object);
+	}
+}
 
+// The narrowphase found 'object' touching the player
+void SceneGraph::playerHitObject(SceneNode * object)
+{
+	// Check if any objects can be collected
+	if (object->hasTag("canCollect") && mPlayerNode->isTractorBeamActive()) {
+		destroy(object);
+		if (object->hasTag("bull")) {
+			mPlayerNode->takeDamage(BULL);
+		}
+		else if (object->hasTag("cow")) {
+			mPlayerNode->addHealth(5);
 		}
+		mPlayerNode->addCollected( object->hasTag("cow") ? "cow" : "hay" );
+		return;
 	}
 
-	return false;
+	mCameraNode->setVelocity(glm::vec3(0));
+}
+
+// Projectiles are swept against the player by the ProjectileStore, see update
+void SceneGraph::projectileHitPlayer(ProjectileNode * projectile)
+{
+	destroy(projectile);
+	if (!mPlayerNode->isShieldActive()) {
+		mPlayerNode->takeDamage(MISSILE);
+	}
+	else {
+		mPlayerNode->addEnergy(-25.0f);
+	}
 }
 
 bool SceneGraph::checkCollisionBetweenObjs(SceneNode * bomb, SceneNode * target)
 {
-	if ((glm::distance(bomb->getPosition(), target->getPosition())) < bomb->getRadius() + target->getRadius()) {
-		target->addTag("delete");
+	// Swept over the tick, so a bomb falling faster than the target is tall still hits it
+	float toi;
+	if (target->getCollisionType() == Capsule) {
+		CollisionShape shape = target->getCollisionShape();
+		glm::vec3 axis = shape.axes[1] * shape.extents.y;
+		toi = SweepCapsule(bomb->getPreviousPosition(), bomb->getPosition(), bomb->getRadius(), shape.center - axis, shape.center + axis, shape.radius);
+	}
+	else if (target->getCollisionType() == Box) {
+		toi = SweepBox(bomb->getPreviousPosition(), bomb->getPosition(), bomb->getRadius(), target->getCollisionShape());
+	}
+	else {
+		toi = SweepSphere(bomb->getPreviousPosition(), bomb->getPosition(), bomb->getRadius(), target->getPreviousPosition(), target->getPosition(), target->getRadius());
+	}
+
+	if (toi >= 0.0f) {
+		destroy(target);
 	}
 	return false;
 }
 
+void SceneGraph::addProxy(SceneNode * node)
+{
+	int layers = 0, mask = 0;
+	if (node->getCollisionType() != None || node->hasTag("canPickUp")) layers |= SolidLayer;
+	if (node->hasTag("bombable")) layers |= BombableLayer;
+
+	glm::vec3 center = node->getPosition();
+	float radius = BoundingRadius(node->getCollisionShape());
+	if (node->hasTag("bomb")) {
+		layers |= BombLayer;
+		mask |= BombableLayer;
+
+		// Bombs are swept, so the proxy covers the whole fall of the tick
+		glm::vec3 previous = node->getPreviousPosition();
+		radius += 0.5f * glm::distance(previous, center);
+		center = 0.5f * (previous + center);
+	}
+
+	if (layers != 0)
+		mBroadphase.add(node, center, radius, layers, mask);
+}
 
-bool SceneGraph::update(double deltaTime)
+void SceneGraph::wakeArea(glm::vec3 center, float radius)
 {
+	// Only the grid cells overlapping the circle can hold anything to wake
+	int minX = (int)floor((center.x - radius) / grid_cell_size_g);
+	int maxX = std::min((int)floor((center.x + radius) / grid_cell_size_g), minX + grid_cells_g - 1);
+	int minY = (int)floor((center.z - radius) / grid_cell_size_g);
+	int maxY = std::min((int)floor((center.z + radius) / grid_cell_size_g), minY + grid_cells_g - 1);
+
+	for (int x = minX; x <= maxX; x++) {
+		for (int y = minY; y <= maxY; y++) {
+			for (SceneNode* node : nodes.at(wrapCell(x)).at(wrapCell(y))) {
+				if (!node->isAsleep())
+					continue;
+
+				glm::vec3 position = node->getPosition();
+				if (glm::distance(glm::vec2(position.x, position.z), glm::vec2(center.x, center.z)) < radius)
+					static_cast<EntityNode*>(node)->wake();
+			}
+		}
+	}
+}
+
+void SceneGraph::deleteArea(glm::vec2 min, glm::vec2 max, std::string tag)
+{
+	int minX = (int)floor(min.x / grid_cell_size_g);
+	int maxX = std::min((int)floor(max.x / grid_cell_size_g), minX + grid_cells_g - 1);
+	int minY = (int)floor(min.y / grid_cell_size_g);
+	int maxY = std::min((int)floor(max.y / grid_cell_size_g), minY + grid_cells_g - 1);
+
+	for (int x = minX; x <= maxX; x++) {
+		for (int y = minY; y <= maxY; y++) {
+			for (SceneNode* node : nodes.at(wrapCell(x)).at(wrapCell(y))) {
+				glm::vec3 position = node->getPosition();
+				if (position.x < min.x || position.x >= max.x || position.z < min.y || position.z >= max.y || !node->hasTag(tag))
+					continue;
+
+				// Sleeping or not, the node goes with the next flush
+				destroy(node);
+			}
+		}
+	}
+}
+
+
+bool SceneGraph::update(double deltaTime, double time)
+{
+	auto updateStart = std::chrono::steady_clock::now();
+
+	TickContext ctx;
+	ctx.time = time;
+	ctx.deltaTime = deltaTime;
+
+	// Anything asleep near the player joins the simulation again
+	wakeArea(mPlayerNode->getPosition(), wake_radius_g);
+
+	// Integrate movement and gravity for every entity in one pass over the EntityStore
+	EntityStore::integrate(ctx);
+
+	ctx.playerPosition = mPlayerNode->getPosition();
+
+	// Wake the entities whose timers expired, on the main thread so they can change the think list
+	TimerQueue::fire(ctx);
+
+	// Parallel phase: every thinking entity decides what to do from the same snapshot of the world
+	// Changes outside an entity's own state are recorded and applied at the sync point below
+	auto thinkStart = std::chrono::steady_clock::now();
+	mJobSystem->parallelFor(EntityStore::getThinkCount(), think_grain_g, [&ctx](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			EntityStore::getThinker(i)->think(ctx);
+		}
+	});
+	auto thinkEnd = std::chrono::steady_clock::now();
+
+	// Sync point
+	CommandBuffer::flush();
+
 	//We iterate through all the nodes twice
 	// Once to update them
 	mRootNode->update(deltaTime);
@@ -188,58 +382,111 @@ bool SceneGraph::update(double deltaTime)
 		return true; 
 	}
 	mPlayerNode->setGridPosition(mPlayerNode->getPosition());
+	mPlayerShape = mPlayerNode->getCollisionShape();
+
+	// The player reaches its hull, or the foot of the tractor beam cone when that is wider
+	float reach = BoundingRadius(mPlayerShape);
+	if (mPlayerNode->isTractorBeamActive())
+		reach = std::max(reach, mPlayerNode->getPosition().y / 4 + 0.25f);
+	mBroadphase.add(mPlayerNode, mPlayerNode->getPosition(), reach, PlayerLayer, SolidLayer);
 
-	// Twice to delete any nodes, plus check collision
+	// Twice to move nodes between grid cells, plus check collision
 	for (int x = 0; x < nodes.size(); x++) {
 		for (int y = 0; y < nodes.at(x).size(); y++) {
 			std::vector<SceneNode*>& cell = nodes.at(x).at(y);
 			for (int i = 0; i < cell.size(); i++) {
 				SceneNode* currentNode = cell.at(i);
 
-				// delete nodes
-				if (currentNode->hasTag("delete")) {
-					deleteNode(currentNode);
-					cell.erase(cell.begin() + i);
-					i--;
-					continue;
-				}
+				// sleeping entities don't move, can't be reached by the player and only wake through wakeArea or their own timers
+				// destroyed nodes are only waiting for the end of the tick
+				if (currentNode->isAsleep() || currentNode->isDestroyed()) continue;
 
 				// ignore player/camera nodes
 				if (currentNode->getName() == "camera" || currentNode->getName() == "player" || currentNode->hasTag("ignore")) continue;
 
 				// update grid location
-				int newX = floor(currentNode->getPosition().x / 20);
-				int newY = floor(currentNode->getPosition().z / 20);
-				newX = glm::clamp(newX, 0, 14);
-				newY = glm::clamp(newY, 0, 14);
+				int newX = getCell(currentNode->getPosition().x);
+				int newY = getCell(currentNode->getPosition().z);
 
 				if (newX != x || newY != y) {
-					cell.erase(cell.begin() + i);
+					gridRemove(currentNode);
 					i--;
-					nodes.at(newX).at(newY).push_back(currentNode);
+					gridInsert(currentNode, newX, newY);
 					currentNode->setGridPosition(newX, newY);
+
+					// A cell still ahead in this pass adds the proxy when it gets to the node,
+					// one already behind never comes back to it
+					if (newX < x || (newX == x && newY < y))
+						addProxy(currentNode);
 					continue;
 				}
 
 
-				// check for collision with the player if the player is in the same grid OR the node is a projectile
-				if (mPlayerNode->getGridPosition() == glm::vec2(x,y) || currentNode->hasTag("projectile")) {
-					checkCollisionWithPlayer(currentNode);
-				}
+				addProxy(currentNode);
+			}
+		}
+	}
 
-				// check collision between hay bombs and cannons
-				// this is where the grid cells structure saves us time
+	// Every pair that can collide this tick, wherever the grid cells put the two sides
+	mBroadphase.build();
+	for (const BroadphasePair& pair : mBroadphase.getPairs()) {
+		SceneNode* a = mBroadphase.getNode(pair.a);
+		SceneNode* b = mBroadphase.getNode(pair.b);
+		if (b->isDestroyed())
+			continue;
 
-				if (currentNode->hasTag("bomb")) {
-					for (SceneNode* object : cell) {
-						if (object->hasTag("bombable")) {
-							checkCollisionBetweenObjs(currentNode, object);
-						}
-					}
-				}
-			}
+		if (mBroadphase.getLayers(pair.a) & PlayerLayer) {
+			checkCollisionWithPlayer(b);
+		}
+		else if ((mBroadphase.getLayers(pair.a) & BombLayer) && (mBroadphase.getLayers(pair.b) & BombableLayer)) {
+			checkCollisionBetweenObjs(a, b);
 		}
 	}
+	mStats.pairs = (int)mBroadphase.getPairs().size();
+	mBroadphase.clear();
+
+	// Every projectile steered, moved, aged and swept against the player in one pass over the ProjectileStore
+	// Hits are applied in the order they happened during the tick
+	glm::vec3 playerPosition = mPlayerNode->getPosition();
+	mExpired.clear();
+	mProjectileHits.clear();
+	ProjectileStore::update(ctx, mLastPlayerPosition, playerPosition, mPlayerNode->getRadius(), mExpired, mProjectileHits);
+	for (ProjectileNode* projectile : mProjectileHits) {
+		projectileHitPlayer(projectile);
+	}
+	for (ProjectileNode* projectile : mExpired) {
+		destroy(projectile);
+	}
+	mLastPlayerPosition = playerPosition;
+
+	// Everything near the player against its hull
+	mHits.clear();
+	mNarrowphase.run(mHits);
+	for (int hit : mHits) {
+		SceneNode* object = mNearPlayer.at(hit);
+		if (!object->isDestroyed())
+			playerHitObject(object);
+	}
+	mNarrowphase.clear();
+	mNearPlayer.clear();
+
+	// Idle entities far from the player stop costing anything until they are woken
+	EntityStore::sleepIdle(mPlayerNode->getPosition(), sleep_radius_g);
+
+	// Safe point: nothing holds on to this tick's destroyed nodes anymore
+	flushDestroyed();
+
+	mStats.threads = mJobSystem->getThreadCount();
+	mStats.entities = EntityStore::getCount();
+	mStats.awake = EntityStore::getAwakeCount();
+	mStats.asleep = EntityStore::getCount() - EntityStore::getAwakeCount();
+	mStats.thinking = EntityStore::getThinkCount();
+	mStats.timers = TimerQueue::getCount();
+	mStats.projectiles = ProjectileStore::getCount();
+	mStats.nodes = NodePool::getLiveCount();
+	mStats.nodeKb = (int)(NodePool::getReservedBytes() / 1024);
+	mStats.thinkMs = std::chrono::duration<double, std::milli>(thinkEnd - thinkStart).count();
+	mStats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
 	return false;
 }
 
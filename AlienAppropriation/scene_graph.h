@@ -18,6 +18,10 @@
 #include "resource_manager.h"
 #include "projectile_node.h"
 #include "entity_node.h"
+#include "job_system.h"
+#include "stats.h"
+#include "collision.h"
+#include "broadphase.h"
 
 namespace game {
 
@@ -32,6 +36,11 @@ namespace game {
 		virtual ~GameException() throw() {};
 	};
 
+	// Collision grid, it wraps around so a fixed number of cells covers an unbounded world
+	// Nodes in one cell can be a multiple of the grid size apart, so every test in a cell still checks distance
+	const int grid_cells_g = 80;
+	const float grid_cell_size_g = 20.0f;
+
     // class SceneGraph
 	// The Scene Graph contains all nodes within the scene.
 	// It is responsible for managing nodes: creating, updating, and deleting
@@ -45,6 +54,9 @@ namespace game {
             // Background color
             glm::vec3 mBackgroundColor;
 
+			// Shader data shared by every program, the lights are set once and the camera fills in the rest each frame
+			FrameUniforms mFrame;
+
 			// Reference to important nodes
 			static BaseNode* mRootNode;
 			static PlayerNode* mPlayerNode;
@@ -52,6 +64,36 @@ namespace game {
 
 			static std::vector<std::vector<std::vector<SceneNode*>>> nodes;
 
+			// Nodes destroyed this tick, unlinked and freed at the end of the update once nothing walks the scene
+			static std::vector<BaseNode*> mDestroyQueue;
+			static void flushDestroyed();
+			// Take a node out of the hierarchy, the grid and the EntityStore, and queue its children
+			static void unlink(BaseNode *node);
+
+			// Grid cells, both O(1) through the node's cell index
+			static void gridInsert(SceneNode *node, int x, int y);
+			static void gridRemove(SceneNode *node);
+
+			// Worker threads for the parallel update phase
+			JobSystem* mJobSystem;
+
+			static Stats mStats;
+
+			// Projectiles that ran out of life or hit the player this tick, see ProjectileStore::update
+			static glm::vec3 mLastPlayerPosition;	// Where the player was at the end of the last tick
+			std::vector<ProjectileNode*> mExpired;
+			std::vector<ProjectileNode*> mProjectileHits;
+
+			// Candidate pairs for the player and the bombs, gathered during the grid pass
+			Broadphase mBroadphase;
+			// File 'node' in the broadphase as whatever its tags and collision type make it
+			void addProxy(SceneNode *node);
+
+			// Objects near the player, tested against its hull in one narrowphase run after the grid pass
+			CollisionShape mPlayerShape;
+			Narrowphase mNarrowphase;
+			std::vector<SceneNode*> mNearPlayer;
+			std::vector<int> mHits;
 
 
 
@@ -66,17 +108,36 @@ namespace game {
             
 			// Basic functionality
 			void draw(Camera *camera);
-			bool update(double deltaTime);
-			bool checkCollisionWithPlayer(SceneNode *object);
+			// time is the game time of this tick, deltaTime the game time since the last one
+			bool update(double deltaTime, double time);
+			void checkCollisionWithPlayer(SceneNode *object);
 			bool checkCollisionBetweenObjs(SceneNode *bomb, SceneNode *target);
+			void projectileHitPlayer(ProjectileNode *projectile);
+			void playerHitObject(SceneNode *object);
+
+			// Wake every sleeping entity within 'radius' of 'center' (in x/z)
+			static void wakeArea(glm::vec3 center, float radius);
+
+			// Destroy every node with 'tag' whose position lies in [min, max) (in x/z)
+			static void deleteArea(glm::vec2 min, glm::vec2 max, std::string tag);
+
+			// Grid cell of a world coordinate along one axis
+			inline static int getCell(float coord) { return wrapCell((int)floor(coord / grid_cell_size_g)); }
+			inline static int wrapCell(int cell)
+			{
+				cell %= grid_cells_g;
+				return cell < 0 ? cell + grid_cells_g : cell;
+			}
 
 			// Getters
 			inline static BaseNode* getRootNode() { return mRootNode; }
 			inline static PlayerNode* getPlayerNode() { return mPlayerNode; }
 			inline Camera* getCameraNode() { return mCameraNode; }
+			inline JobSystem* getJobSystem() { return mJobSystem; }
+			inline static Stats& getStats() { return mStats; }
 
 			// Setters
-			inline void setPlayerNode(PlayerNode* player) { mPlayerNode = player; }
+			inline void setPlayerNode(PlayerNode* player) { mPlayerNode = player; mLastPlayerPosition = player->getPosition(); }
 
 			// Hierarchy Management
 			static void addNode(SceneNode *node, BaseNode *parent = nullptr) 
@@ -89,16 +150,15 @@ namespace game {
 					node->setParentNode(mRootNode);
 					mRootNode->addChildNode(node);
 				}
-				int x = (int)floor(node->getPosition().x / 20.0f);
-				int y = (int)floor(node->getPosition().y / 20.0f);
-				x = glm::clamp(x, 0, 14);
-				y = glm::clamp(y, 0, 14);
+				int x = getCell(node->getPosition().x);
+				int y = getCell(node->getPosition().z);
 				node->setGridPosition(x, y);
 
-				nodes.at(x).at(y).push_back(node);
+				gridInsert(node, x, y);
 			}
 
-			void deleteNode(BaseNode *node);
+			// Queue 'node' and its children for destruction at the end of the tick
+			static void destroy(BaseNode *node);
 			void deleteNode(std::string name);
 			BaseNode* getNode(std::string node_name);
 
@@ -121,14 +181,9 @@ namespace game {
 				// Create scene node with the specified resources
 				T* scn = new T(node_name, geometry, material, lifespan, initialPos, initialVelocityVec, texture);
 
-				// Add node to the scene
+				// Add node to the scene, the ProjectileStore takes care of its collisions so it stays out of the grid
 				mRootNode->addChildNode(scn);
 				scn->setParentNode(mRootNode);
-				int x = glm::clamp((int)floor(initialPos.x / 20.0f), 0, 14);
-				int y = glm::clamp((int)floor(initialPos.y / 20.0f), 0, 14);
-
-				nodes.at(x).at(y).push_back(scn);
-				scn->setGridPosition(x, y);
 
 				return scn;
 			}
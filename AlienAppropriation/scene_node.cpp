@@ -3,6 +3,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <algorithm>
 #include <time.h>
 
 
@@ -13,14 +14,29 @@
 #include <glm/gtx/norm.hpp>
 
 #include "scene_node.h"
+#include "scene_graph.h"
 
 namespace game {
+
+// Smallest size on screen, in pixels, at which each level of detail is used (level 0 is the full mesh)
+const float lod_pixels_g[] = { 0.0f, 160.0f, 70.0f, 30.0f };
+// A node has to grow this much past a threshold before it goes back to the finer level
+const float lod_hysteresis_g = 1.2f;
+// Nodes smaller than this on screen are not drawn at all
+const float lod_cull_pixels_g = 1.0f;
+
 	SceneNode::SceneNode(const std::string name) : BaseNode(name)
+		, mCell(0, 0)
+		, mCellIndex(-1)
+		, mGeometry(NULL)
+		, mLodLevel(0)
 	{
 	}
 
 	SceneNode::SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture, const Resource *envmap)
 	: BaseNode(name)
+	, mCell(0, 0)
+	, mCellIndex(-1)
 {
     // Set geometry
     if (geometry->getType() == PointSet){
@@ -34,6 +50,8 @@ namespace game {
     mArrayBuffer = geometry->getArrayBuffer();
     mElementArrayBuffer = geometry->getElementArrayBuffer();
     mSize = geometry->getSize();
+    mGeometry = geometry;
+    mLodLevel = 0;
 
     // Set material (shader program)
     if (material->getType() != Material){
@@ -83,6 +101,50 @@ glm::quat SceneNode::getOrientation(void) const {
 }
 
 
+CollisionShape SceneNode::getCollisionShape(void) {
+
+	CollisionShape shape;
+	shape.type = collisionType;
+	shape.center = getPosition();
+	shape.radius = radius;
+	shape.extents = glm::vec3(radius);
+	shape.axes[0] = glm::vec3(1, 0, 0);
+	shape.axes[1] = glm::vec3(0, 1, 0);
+	shape.axes[2] = glm::vec3(0, 0, 1);
+
+	// Points, and meshes that were never measured, are spheres of the node's radius
+	// Every node is asked every tick, so these stay cheap
+	if (collisionType == Point || collisionType == None || !mGeometry || !mGeometry->hasBounds()) {
+		if (collisionType != None) shape.type = Point;
+		return shape;
+	}
+
+	glm::mat3 rotation = glm::mat3_cast(mOrientation);
+	for (int i = 0; i < 3; i++) {
+		shape.axes[i] = rotation[i];
+	}
+
+	// The mesh bounds in the node's frame, scaled like the mesh is drawn
+	glm::vec3 min = mGeometry->getBoundsMin() * mScale;
+	glm::vec3 max = mGeometry->getBoundsMax() * mScale;
+	glm::vec3 extents = 0.5f * glm::abs(max - min);
+	shape.center += rotation * (0.5f * (min + max));
+
+	if (collisionType == Box) {
+		shape.extents = extents;
+		return shape;
+	}
+
+	// Capsules run along the longest side of the bounds and are as thick as the wider of the other two
+	int axis = extents.x > extents.y ? (extents.x > extents.z ? 0 : 2) : (extents.y > extents.z ? 1 : 2);
+	std::swap(shape.axes[1], shape.axes[axis]);
+	std::swap(extents[1], extents[axis]);
+	shape.radius = std::max(extents.x, extents.z);
+	shape.extents = glm::vec3(shape.radius, std::max(extents.y - shape.radius, 0.0f), shape.radius);
+	return shape;
+}
+
+
 glm::vec3 SceneNode::getscale(void) const {
 
     return mScale;
@@ -92,24 +154,27 @@ glm::vec3 SceneNode::getscale(void) const {
 void SceneNode::setPosition(glm::vec3 position){
 
     mPosition = position;
+    markTransformDirty();
 }
 
 
 void SceneNode::setOrientation(glm::quat orientation){
 
     mOrientation = orientation;
+    markTransformDirty();
 }
 
 
 void SceneNode::setScale(glm::vec3 scale){
 
     mScale = scale;
+    markTransformDirty();
 }
 
 void SceneNode::setGridPosition(glm::vec3 pos)
 {
-	gridPosition.x = floor(pos.x / 20);
-	gridPosition.y = floor(pos.z / 20);
+	gridPosition.x = SceneGraph::getCell(pos.x);
+	gridPosition.y = SceneGraph::getCell(pos.z);
 }
 
 void SceneNode::setGridPosition(int x, int y)
@@ -126,7 +191,7 @@ void SceneNode::setEnvMap(Resource* envmap)
 void SceneNode::translate(glm::vec3 trans){
 
     mPosition += trans;
-	
+    markTransformDirty();
 }
 
 
@@ -134,6 +199,7 @@ void SceneNode::rotate(glm::quat rot){
 
     mOrientation *= rot;
     mOrientation = glm::normalize(mOrientation);
+    markTransformDirty();
 }
 
 // Code adapted from https://github.com/opengl-tutorials/ogl/blob/master/common/quaternion_utils.cpp
@@ -168,6 +234,7 @@ void SceneNode::rotate(glm::vec3 direction)
 void SceneNode::scale(glm::vec3 scale){
 
     mScale *= scale;
+    markTransformDirty();
 }
 
 
@@ -207,8 +274,54 @@ GLuint SceneNode::getTexture(void) const {
 }
 
 
+bool SceneNode::SelectLod(SceneNode *camera, const glm::mat4 &parentTransf){
+
+	if (!mGeometry || mGeometry->getLods().empty()) {
+		return true;
+	}
+
+	// Diameter of the bounding sphere in pixels
+	glm::vec3 world_position = glm::vec3(parentTransf * glm::vec4(getPosition(), 1.0f));
+	float distance = std::max(glm::distance(world_position, camera->getPosition()), 0.01f);
+	float scale = std::max(mScale.x, std::max(mScale.y, mScale.z));
+	float pixels = 2.0f * mGeometry->getBoundingRadius() * scale * static_cast<Camera*>(camera)->GetPixelsPerUnit() / distance;
+
+	// Not worth a draw call
+	if (pixels < lod_cull_pixels_g) {
+		return false;
+	}
+
+	// Coarser as soon as the node gets small enough, finer only once it is clearly bigger again
+	// so nodes near a threshold don't swap meshes every frame
+	int max_level = (int)mGeometry->getLods().size();
+	while (mLodLevel < max_level && pixels < lod_pixels_g[mLodLevel + 1]) {
+		mLodLevel++;
+	}
+	while (mLodLevel > 0 && pixels > lod_pixels_g[mLodLevel] * lod_hysteresis_g) {
+		mLodLevel--;
+	}
+
+	if (mLodLevel == 0) {
+		mArrayBuffer = mGeometry->getArrayBuffer();
+		mElementArrayBuffer = mGeometry->getElementArrayBuffer();
+		mSize = mGeometry->getSize();
+	}
+	else {
+		const Resource::Lod &lod = mGeometry->getLods()[mLodLevel - 1];
+		mArrayBuffer = lod.mArrayBuffer;
+		mElementArrayBuffer = lod.mElementArrayBuffer;
+		mSize = lod.mSize;
+	}
+	return true;
+}
+
+
 void SceneNode::draw(SceneNode *camera, glm::mat4 parentTransf){
 
+	if (!SelectLod(camera, parentTransf)) {
+		return;
+	}
+
 	// Select proper material (shader program)
 	glUseProgram(mMaterial);
 
@@ -216,9 +329,6 @@ void SceneNode::draw(SceneNode *camera, glm::mat4 parentTransf){
 	glBindBuffer(GL_ARRAY_BUFFER, mArrayBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementArrayBuffer);
 
-	// Set globals for camera
-	camera->SetupShader(mMaterial);
-
 	// Set world matrix and other shader input variables
 	SetupShader(mMaterial, parentTransf);
 
@@ -228,6 +338,7 @@ void SceneNode::draw(SceneNode *camera, glm::mat4 parentTransf){
 	}
 	else {
 		glDrawElements(mMode, mSize, GL_UNSIGNED_INT, 0);
+		SceneGraph::getStats().triangles += mSize / 3;
 	}
 
 	for (BaseNode* bn : getChildNodes())
@@ -240,7 +351,6 @@ void SceneNode::draw(SceneNode *camera, glm::mat4 parentTransf){
 
 void SceneNode::update(double deltaTime)
 {
-	mPosition = glm::clamp(mPosition, 0.0f, 300.0f); // clamp to map limits
 	gridPosition = glm::vec2(floor(mPosition.x / 15), floor(mPosition.z / 15));
 
 	for (BaseNode* bn : getChildNodes())
@@ -253,6 +363,27 @@ void SceneNode::update(double deltaTime)
 
 
 
+void SceneNode::updateTransform(const glm::mat4& parentTransf){
+
+	mWorld = glm::translate(parentTransf, getPosition()) * glm::mat4_cast(mOrientation);
+	mWorldScaled = glm::scale(mWorld, mScale);
+
+	// The normal matrix is the inverse transpose of the world matrix. Scale is never handed down to children,
+	// so mWorld is only translations and rotations and its inverse transpose is its own rotation part.
+	// The node's scale then goes in as its reciprocal; a uniform scale only changes the normals' length,
+	// which lighting normalises away, so it is skipped
+	glm::mat3 normal_matrix(mWorld);
+	if (mScale.x != mScale.y || mScale.y != mScale.z) {
+		normal_matrix[0] /= mScale.x;
+		normal_matrix[1] /= mScale.y;
+		normal_matrix[2] /= mScale.z;
+	}
+	mNormalMatrix = glm::mat4(normal_matrix);
+
+	mTransformDirty = false;
+}
+
+
 void SceneNode::SetupShader(GLuint program, glm::mat4& parentTransf /*= glm::mat4(1.0)*/){
 
     // Set attributes for shaders
@@ -272,18 +403,14 @@ void SceneNode::SetupShader(GLuint program, glm::mat4& parentTransf /*= glm::mat
     glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (9*sizeof(GLfloat)));
     glEnableVertexAttribArray(tex_att);
 
-	// Aply transformations *ISROT*
-	glm::mat4 rotation = glm::mat4_cast(mOrientation);
-	glm::mat4 translation = glm::translate(parentTransf, mPosition);
-
-	parentTransf = translation * rotation;
+	// Aply transformations *ISROT*, cached until the node or a parent moves
+	if (mTransformDirty) {
+		updateTransform(parentTransf);
+	}
+	parentTransf = mWorld;
 
-    GLint world_mat = glGetUniformLocation(program, "world_mat");
-    glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(glm::scale(parentTransf, mScale)));
-	 // Normal matrix
-    glm::mat4 normal_matrix = glm::transpose(glm::inverse(parentTransf));
-    GLint normal_mat = glGetUniformLocation(program, "normal_mat");
-    glUniformMatrix4fv(normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix));
+	// World and normal matrix, the camera's part went up with the frame data
+	UniformBuffers::SetObject(mWorldScaled, mNormalMatrix);
 
 
 	// Texture
@@ -304,12 +431,6 @@ void SceneNode::SetupShader(GLuint program, glm::mat4& parentTransf /*= glm::mat
 		GLint useEnv = glGetUniformLocation(program, "useEnvMap");
 		glUniform1i(useEnv, false);
 	}
-
-
-    // Timer
-    GLint timer_var = glGetUniformLocation(program, "timer");
-    double current_time = glfwGetTime();
-    glUniform1f(timer_var, (float) current_time);
 }
 
 // Source code from https://github.com/opengl-tutorials/ogl/blob/master/common/quaternion_utils.cpp
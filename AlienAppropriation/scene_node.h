@@ -11,10 +11,9 @@
 
 #include "base_node.h"
 #include "resource.h"
+#include "collision.h"
 
 namespace game {
-	
-	enum CollisionType { Point, Capsule, None };
 
 	// class SceneNode
 	// A node that exists within a scene. It has a 3D transform.
@@ -34,6 +33,11 @@ namespace game {
 			float radius;
 			CollisionType collisionType;
 
+			// Spatial grid membership, kept up to date by the SceneGraph
+			glm::ivec2 mCell;	// Cell the node is filed under
+			int mCellIndex;		// Position in that cell, -1 if the node is not in the grid
+			friend class SceneGraph;
+
 			// drawing
 			GLuint mArrayBuffer; // References to geometry: vertex and array buffers
 			GLuint mElementArrayBuffer;
@@ -43,12 +47,26 @@ namespace game {
 			GLuint mTexture; // Reference to texture resource
 			GLuint mEnvmap; // Reference to environment map
 
+			// Cached transforms, rebuilt by updateTransform only when the node or a parent has moved
+			glm::mat4 mWorld; // Parent transform, translation and rotation: what children are placed in
+			glm::mat4 mWorldScaled; // mWorld with the node's own scale, the world matrix it is drawn with
+			glm::mat4 mNormalMatrix;
+			void updateTransform(const glm::mat4& parentTransf);
+
+			// Level of detail
+			const Resource *mGeometry; // Full mesh and its simplified levels
+			int mLodLevel; // Level drawn last frame, 0 is the full mesh
+
 
 			// Quaternion helper function
 			// Finds a quat such that q*start = dest
 			// Source code from https://github.com/opengl-tutorials/ogl/blob/master/common/quaternion_utils.cpp
 			glm::quat QuatBetweenVectors(glm::vec3 start, glm::vec3 dest);
 
+			// Choose the level of detail from the node's size on screen and bind it to the draw variables
+			// Returns false if the node is too small to be worth drawing
+			bool SelectLod(SceneNode *camera, const glm::mat4 &parentTransf);
+
 		public:
 			SceneNode(const std::string name);
 			SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture = NULL, const Resource *envmap = NULL);
@@ -59,18 +77,24 @@ namespace game {
 			virtual void update(double deltaTime);
 
 			// Transformations
-			void translate(glm::vec3 trans);
+			virtual void translate(glm::vec3 trans);
 			void rotate(glm::quat rot);
 			void rotate(glm::vec3 direction);
 			void scale(glm::vec3 scale);
 
 			// Getters
 			virtual glm::vec3 getPosition(void);
+			// Position at the start of the tick, the same as getPosition for nodes that don't move on their own
+			virtual glm::vec3 getPreviousPosition(void) { return getPosition(); }
 			glm::quat getOrientation(void) const;
 			glm::vec3 getscale(void) const;
 			inline glm::vec2 getGridPosition(void) { return gridPosition; }
 			inline float getRadius(void) { return radius; }
 			inline CollisionType getCollisionType(void) { return collisionType; }
+			// Collision volume in world space, sized from the mesh bounds for capsules and boxes
+			CollisionShape getCollisionShape(void);
+			// Sleeping nodes are skipped by the per-tick grid and collision pass
+			virtual bool isAsleep(void) { return false; }
 
 			// OpenGL variables
 			GLenum getMode(void) const;
@@ -81,12 +105,13 @@ namespace game {
 			GLuint getTexture(void) const;
 
 			// Setters
-			void setPosition(glm::vec3 position);
+			virtual void setPosition(glm::vec3 position);
 			void setOrientation(glm::quat orientation);
 			void setScale(glm::vec3 scale);
 			void setGridPosition(glm::vec3 pos);
 			void setGridPosition(int x, int y);
 			void setEnvMap(Resource *envmap);
+			inline void setCollisionType(CollisionType type) { collisionType = type; }
 			virtual void SetupShader(GLuint program, glm::mat4& parentTransf = glm::mat4(1.0));	// Set matrices that transform the node in a shader program
 
 
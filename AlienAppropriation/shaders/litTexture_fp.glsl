@@ -1,6 +1,6 @@
 // Renders texture and applies lighting on top
 
-#version 130
+#version 140
 
 // Attributes passed from the vertex shader
 in vec3 position_interp;
@@ -11,13 +11,22 @@ in vec2 uv_interp;
 // Uniform (global) buffer
 uniform sampler2D texture_map;
 
+// Lights, shared by every program and uploaded once per frame
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
 // Material attributes (constants)
-uniform vec3 light_direction = vec3(-1.0, -0.7, -1.0); //direction of the directional light
-uniform vec4 ambient_color = vec4(1.0, 1.0, 1.0, 1.0);
-uniform vec4 diffuse_color = vec4(0.6, 0.6, 0.6, 1.0);
-uniform vec4 specular_color = vec4(0.7, 0.7, 0.7, 1.0);
 float phong_exponent = 7.0;
-uniform float Ia = 0.4; // Ambient light amount
 
 
 // Uniform (global) buffer with the environment map
@@ -33,7 +42,7 @@ void main()
 	// Compute Lambertian term Id
 	N = normalize(normal_interp);
 
-	L = -normalize(light_direction);
+	L = -normalize(light_direction.xyz);
 
 	float Id = max(dot(N, L), 0.0);
     
@@ -49,7 +58,7 @@ void main()
 
     // Assign illumination to the fragment
 	// Lighting is multiplied with the ambient color
-	vec4 illum = pixel * Ia + Id * diffuse_color;
+	vec4 illum = pixel * ambient_amount + Id * light_diffuse;
 	
 	if(useEnvMap) {
 		// Compute indirect lighting with environment map
@@ -0,0 +1,65 @@
+#version 400
+
+// Vertex buffer
+in vec3 vertex;
+in vec3 normal;
+in vec3 color;
+
+// Uniform (global) buffer
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
+layout(std140) uniform ObjectData {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
+// Attributes passed to the fragment shader
+out vec4 frag_color;
+
+// Simulation parameters (constants)
+uniform float particle_size = 0.05;
+uniform vec3 up_vec = vec3(0.0, 1.0, 0.0);
+uniform vec3 object_color = vec3(0.8, 0.8, 0.8);
+float grav = 0.005; // Gravity
+float speed = 2.5; // Allows to control the speed of the explosion
+
+
+void main()
+{
+    // Let time cycle every four seconds
+	float particle_id = color.r;
+	float phase = particle_id * 80;
+	float time = timer + phase;
+    float t = time - 80.0 * floor(time / 80);
+	float t2 = timer - 80.0 * floor(timer / 80);
+
+    // Let's first work in model space (apply only world matrix)
+    vec4 position = world_mat * vec4(vertex, 1.0);
+    vec4 norm = normal_mat * vec4(normal, 1.0);
+
+	float offset = 0;
+	if (norm.x < 0) offset = 3.14159;
+
+    // Move point along normal and down with t*t (acceleration under gravity)
+    position.x += (t / 20) * sin(t + offset + t2);
+    position.y -= t/2;
+    position.z += (t / 20) * cos(t + offset + t2);
+    
+    // Now apply view and projection, the sprite covers particle_size world units at the particle's depth
+    vec4 view_position = view_mat * position;
+    gl_Position = projection_mat * view_position;
+    gl_PointSize = max(particle_size * pixels_per_unit / -view_position.z, 1.0);
+
+    frag_color = vec4(object_color, 1.0);
+}
@@ -9,7 +9,18 @@ in vec3 vertex_color[];
 in float timestep[];
 
 // Uniform (global) buffer
-uniform mat4 projection_mat;
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
 
 // Simulation parameters (constants)
 uniform float particle_size = 0.1;
@@ -0,0 +1,9 @@
+#version 400
+
+// Attributes passed from the vertex shader
+in vec4 frag_color;
+
+void main (void)
+{
+    gl_FragColor = frag_color;
+}
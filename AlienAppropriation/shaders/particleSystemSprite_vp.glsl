@@ -0,0 +1,47 @@
+#version 400
+
+// Particle state, positions are already in world space
+in vec3 position;
+in vec3 color;
+in vec2 life;
+
+// Uniform (global) buffer
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
+// Simulation parameters (constants)
+uniform float particle_size = 0.4;
+
+// Attributes passed to the fragment shader
+out vec4 frag_color;
+
+
+void main()
+{
+    // Share of the lifetime left, 0 or less for dead slots
+    float remaining = life.y > 0.0 ? 1.0 - life.x / life.y : 0.0;
+
+    // Dead particles are moved out of the clip volume so they are dropped before rasterization
+    if (remaining <= 0.0) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        frag_color = vec4(0.0);
+        return;
+    }
+
+    // Shrink the particle as it ages
+    vec4 view_position = view_mat * vec4(position, 1.0);
+    gl_Position = projection_mat * view_position;
+    gl_PointSize = max(particle_size * remaining * pixels_per_unit / -view_position.z, 1.0);
+    frag_color = vec4(color, 1.0);
+}
@@ -0,0 +1,56 @@
+#version 400
+
+// Definition of the geometry shader
+layout (points) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+// Attributes passed from the vertex shader
+in vec3 vertex_color[];
+in float remaining[];
+
+// Uniform (global) buffer
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
+// Simulation parameters (constants)
+uniform float particle_size = 0.4;
+
+// Attributes passed to the fragment shader
+out vec4 frag_color;
+
+
+void main(void){
+
+    // Dead particles produce nothing
+    if (remaining[0] <= 0.0) {
+        return;
+    }
+
+    // Shrink the particle as it ages, we are already in camera space so offsets face the camera
+    vec4 position = gl_in[0].gl_Position;
+    float p_size = particle_size * remaining[0];
+
+    vec4 v[4];
+    v[0] = vec4(position.x - 0.5*p_size, position.y - 0.5*p_size, position.z, 1.0);
+    v[1] = vec4(position.x + 0.5*p_size, position.y - 0.5*p_size, position.z, 1.0);
+    v[2] = vec4(position.x - 0.5*p_size, position.y + 0.5*p_size, position.z, 1.0);
+    v[3] = vec4(position.x + 0.5*p_size, position.y + 0.5*p_size, position.z, 1.0);
+
+    for (int i = 0; i < 4; i++){
+        gl_Position = projection_mat * v[i];
+        frag_color = vec4(vertex_color[0], 1.0);
+        EmitVertex();
+    }
+
+    EndPrimitive();
+}
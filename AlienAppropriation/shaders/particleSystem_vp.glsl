@@ -0,0 +1,34 @@
+#version 400
+
+// Particle state, positions are already in world space
+in vec3 position;
+in vec3 color;
+in vec2 life;
+
+// Uniform (global) buffer
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
+// Attributes forwarded to the geometry shader
+out vec3 vertex_color;
+out float remaining;
+
+
+void main()
+{
+    gl_Position = view_mat * vec4(position, 1.0);
+    vertex_color = color;
+
+    // Share of the lifetime left, 0 or less for dead slots
+    remaining = life.y > 0.0 ? 1.0 - life.x / life.y : 0.0;
+}
@@ -0,0 +1,87 @@
+#version 400
+
+// Particle state, read from one buffer and written to the other with transform feedback
+in vec3 position;
+in vec3 velocity;
+in vec3 color;
+in vec2 life; // x: age, y: lifetime, both in seconds. Dead once age >= lifetime
+
+// Captured outputs, in the same layout as the inputs
+out vec3 out_position;
+out vec3 out_velocity;
+out vec3 out_color;
+out vec2 out_life;
+
+// Uniform (global) buffer
+uniform float delta_time;
+uniform float time;
+uniform vec3 gravity;
+uniform int capacity;
+
+// Slots respawned this update: emitter i takes spawn_count[i] slots from spawn_first[i] on, wrapping at capacity
+const int max_spawns = 16;
+uniform int spawn_emitters;
+uniform int spawn_first[max_spawns];
+uniform int spawn_count[max_spawns];
+uniform vec3 spawn_position[max_spawns];
+uniform vec3 spawn_velocity[max_spawns];
+uniform vec3 spawn_color[max_spawns];
+uniform vec3 spawn_shape[max_spawns]; // x: spread, y: shortest lifetime, z: longest lifetime
+
+// Debris keeps this much of its speed when it lands
+float ground_friction = 0.3;
+
+
+// Random number in [0, 1) from an integer hash
+float random(uint seed)
+{
+    seed ^= seed >> 16;
+    seed *= 0x7FEB352Du;
+    seed ^= seed >> 15;
+    seed *= 0x846CA68Bu;
+    seed ^= seed >> 16;
+    return float(seed >> 8) / 16777216.0;
+}
+
+
+void main()
+{
+    vec3 p = position;
+    vec3 v = velocity;
+    vec3 c = color;
+    vec2 l = life;
+
+    // Move and age the living
+    if (l.x < l.y) {
+        v += gravity * delta_time;
+        p += v * delta_time;
+        l.x += delta_time;
+
+        // Settle on the ground instead of falling through it
+        if (p.y < 0.0) {
+            p.y = 0.0;
+            v = vec3(v.x, 0.0, v.z) * ground_friction;
+        }
+    }
+
+    // Respawn the slot if an emitter claimed it
+    for (int i = 0; i < spawn_emitters; i++) {
+        int slot = gl_VertexID - spawn_first[i];
+        if (slot < 0) slot += capacity;
+        if (slot < spawn_count[i]) {
+            uint seed = uint(gl_VertexID) * 5u + floatBitsToUint(time) * 0x9E3779B9u;
+            vec3 direction = vec3(random(seed), random(seed + 1u), random(seed + 2u)) * 2.0 - 1.0;
+            direction /= max(length(direction), 0.001);
+
+            p = spawn_position[i];
+            v = spawn_velocity[i] + direction * spawn_shape[i].x * random(seed + 3u);
+            c = spawn_color[i];
+            l = vec2(0.0, mix(spawn_shape[i].y, spawn_shape[i].z, random(seed + 4u)));
+        }
+    }
+
+    out_position = p;
+    out_velocity = v;
+    out_color = c;
+    out_life = l;
+}
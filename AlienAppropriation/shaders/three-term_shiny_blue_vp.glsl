@@ -1,6 +1,6 @@
 // Illumination based on the traditional three-term model
 
-#version 130
+#version 140
 
 // Vertex buffer
 in vec3 vertex;
@@ -8,10 +8,23 @@ in vec3 normal;
 in vec3 color;
 
 // Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_mat;
+layout(std140) uniform FrameData {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_direction; // Direction of the directional light
+    vec4 light_ambient;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    float timer;
+    float pixels_per_unit; // Screen pixels covered by one world unit at distance 1
+    float ambient_amount;
+};
+
+layout(std140) uniform ObjectData {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
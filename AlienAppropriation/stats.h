@@ -0,0 +1,27 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+namespace game {
+
+	// struct Stats
+	// Counters collected while updating the scene, shown in the window title
+	struct Stats {
+		int threads = 1;			// Threads used by the parallel update phase
+		int entities = 0;			// Live slots in the EntityStore
+		int awake = 0;				// Entities simulated this tick
+		int asleep = 0;				// Idle entities skipped until something wakes them
+		int thinking = 0;			// Entities that ran think this tick
+		int timers = 0;				// Wake-ups waiting in the TimerQueue (including stale ones)
+		int projectiles = 0;		// Projectiles in flight, in the ProjectileStore
+		int nodes = 0;				// Scene nodes alive in the NodePool
+		int nodeKb = 0;				// Memory the NodePool holds for them, live or free
+		double updateMs = 0.0;		// Time spent in SceneGraph::update
+		double thinkMs = 0.0;		// Time spent in the parallel behaviour phase
+		int triangles = 0;			// Triangles submitted by the last frame
+		int particles = 0;			// Particles spawned on the GPU this tick
+		int pairs = 0;				// Candidate pairs from the broadphase this tick
+	};
+
+} // namespace game
+
+#endif // STATS_H_
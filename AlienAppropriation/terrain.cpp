@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cmath>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "terrain.h"
+#include "scene_graph.h"
+
+namespace game {
+
+// Chunk layout
+const float chunk_size_g = 100.0f;		// World units per chunk side
+const int chunk_quads_g = 32;			// Quads per chunk side at full detail
+const int chunk_verts_g = chunk_quads_g + 1;
+const int chunk_lods_g = 4;				// Each level halves the quads per side
+const float skirt_depth_g = 2.0f;		// How far the skirts hang below the edges
+
+// Streaming
+const int view_chunks_g = 6;			// Chunks kept around the camera, in each direction
+const int chunk_builds_per_update_g = 4;	// New chunks built per update, so moving fast never stalls a frame
+
+// Level of detail
+const float lod_distance_g = 150.0f;	// Full detail up to this distance, each further doubling drops a level
+
+// Heightfield
+const float height_scale_g = 0.5f;		// Gentle relief, entities still stand at y = 0
+const float height_frequency_g = 1.0f / 40.0f;
+const float texture_repeat_g = 10.0f;	// World units per repeat of the ground texture
+
+const int vertex_att_g = 11;
+
+
+Terrain::Terrain(const std::string name, SceneNode *camera, const Resource *material, const Resource *texture, uint32_t seed)
+	: SceneNode(name)
+	, mCamera(camera)
+	, mSeed(seed)
+{
+	mMaterial = material->getResource();
+	mTexture = texture ? texture->getResource() : 0;
+	mEnvmap = 0;
+	mMode = GL_TRIANGLES;
+	mArrayBuffer = 0;
+	mElementArrayBuffer = 0;
+	mSize = 0;
+	mPosition = glm::vec3(0.0f);
+	mScale = glm::vec3(1.0f);
+	radius = 0.0f;
+	collisionType = None;
+
+	// Never part of the collision sweep
+	addTag("ignore");
+
+	// Textures are loaded without mipmaps and draw samples with a mipmap filter
+	// The ground texture is only drawn here, so nothing else generates them
+	if (mTexture) {
+		glBindTexture(GL_TEXTURE_2D, mTexture);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	buildIndexBuffers();
+}
+
+Terrain::~Terrain()
+{
+	for (auto &entry : mChunks) {
+		glDeleteBuffers(1, &entry.second.vbo);
+	}
+	if (!mFreeBuffers.empty()) {
+		glDeleteBuffers((GLsizei)mFreeBuffers.size(), mFreeBuffers.data());
+	}
+	glDeleteBuffers((GLsizei)mLodBuffers.size(), mLodBuffers.data());
+}
+
+
+float Terrain::lattice(int x, int z) const
+{
+	// Integer hash of the lattice point and the seed
+	uint32_t h = mSeed ^ ((uint32_t)x * 0x8DA6B343u) ^ ((uint32_t)z * 0xD8163841u);
+	h = (h ^ (h >> 16)) * 0x7FEB352Du;
+	h = (h ^ (h >> 15)) * 0x846CA68Bu;
+	h ^= h >> 16;
+	return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+float Terrain::noise(float x, float z) const
+{
+	int x0 = (int)std::floor(x), z0 = (int)std::floor(z);
+	float fx = x - x0, fz = z - z0;
+
+	// Smoothstep between the four lattice values
+	fx = fx * fx * (3.0f - 2.0f * fx);
+	fz = fz * fz * (3.0f - 2.0f * fz);
+
+	float a = lattice(x0, z0), b = lattice(x0 + 1, z0);
+	float c = lattice(x0, z0 + 1), d = lattice(x0 + 1, z0 + 1);
+	return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fz);
+}
+
+float Terrain::getHeight(float x, float z) const
+{
+	// Two octaves
+	float h = 0.67f * noise(x * height_frequency_g, z * height_frequency_g)
+		+ 0.33f * noise(x * height_frequency_g * 2.0f + 17.0f, z * height_frequency_g * 2.0f + 31.0f);
+	return height_scale_g * h;
+}
+
+
+void Terrain::buildIndexBuffers(void)
+{
+	const int grid_count = chunk_verts_g * chunk_verts_g;
+
+	mLodBuffers.resize(chunk_lods_g);
+	mLodSizes.resize(chunk_lods_g);
+	glGenBuffers(chunk_lods_g, mLodBuffers.data());
+
+	for (int lod = 0; lod < chunk_lods_g; lod++)
+	{
+		int step = 1 << lod;
+		std::vector<GLuint> index;
+
+		// Grid, two triangles per quad, skipping vertices between the ones this level uses
+		for (int x = 0; x < chunk_quads_g; x += step) {
+			for (int z = 0; z < chunk_quads_g; z += step) {
+				GLuint v00 = x * chunk_verts_g + z, v01 = x * chunk_verts_g + z + step;
+				GLuint v10 = (x + step) * chunk_verts_g + z, v11 = (x + step) * chunk_verts_g + z + step;
+				index.insert(index.end(), { v00, v01, v10, v01, v11, v10 });
+			}
+		}
+
+		// Skirts, one strip per edge: edge vertex k of edge e hangs down to skirt vertex grid_count + e * chunk_verts_g + k
+		for (int e = 0; e < 4; e++) {
+			for (int k = 0; k < chunk_quads_g; k += step) {
+				GLuint top[2], bottom[2];
+				for (int i = 0; i < 2; i++) {
+					int t = k + i * step;
+					int x = (e == 0) ? 0 : (e == 1) ? chunk_quads_g : t;
+					int z = (e == 2) ? 0 : (e == 3) ? chunk_quads_g : t;
+					top[i] = x * chunk_verts_g + z;
+					bottom[i] = grid_count + e * chunk_verts_g + t;
+				}
+				index.insert(index.end(), { top[0], bottom[0], top[1], top[1], bottom[0], bottom[1] });
+			}
+		}
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mLodBuffers[lod]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, index.size() * sizeof(GLuint), index.data(), GL_STATIC_DRAW);
+		mLodSizes[lod] = (GLsizei)index.size();
+	}
+}
+
+void Terrain::buildChunk(Chunk &chunk)
+{
+	const int grid_count = chunk_verts_g * chunk_verts_g;
+	const float spacing = chunk_size_g / chunk_quads_g;
+	const float origin_x = chunk.x * chunk_size_g, origin_z = chunk.z * chunk_size_g;
+
+	std::vector<GLfloat> vertex((grid_count + 4 * chunk_verts_g) * vertex_att_g, 0.0f);
+
+	auto write = [&](int index, float x, float y, float z, glm::vec3 normal) {
+		GLfloat *att = &vertex[index * vertex_att_g];
+		// Position relative to the chunk origin, normal, white color, world-space texture coordinates
+		att[0] = x - origin_x; att[1] = y; att[2] = z - origin_z;
+		att[3] = normal.x; att[4] = normal.y; att[5] = normal.z;
+		att[6] = 1.0f; att[7] = 1.0f; att[8] = 1.0f;
+		att[9] = x / texture_repeat_g; att[10] = z / texture_repeat_g;
+	};
+
+	for (int i = 0; i < chunk_verts_g; i++) {
+		for (int j = 0; j < chunk_verts_g; j++) {
+			float x = origin_x + i * spacing, z = origin_z + j * spacing;
+
+			// Normal from central differences, sampled from the height function so it is continuous across chunks
+			float dx = getHeight(x + spacing, z) - getHeight(x - spacing, z);
+			float dz = getHeight(x, z + spacing) - getHeight(x, z - spacing);
+			glm::vec3 normal = glm::normalize(glm::vec3(-dx, 2.0f * spacing, -dz));
+
+			write(i * chunk_verts_g + j, x, getHeight(x, z), z, normal);
+		}
+	}
+
+	// Skirt vertices sit below the edge vertices, in the same order as the index buffers expect
+	for (int e = 0; e < 4; e++) {
+		for (int k = 0; k < chunk_verts_g; k++) {
+			int i = (e == 0) ? 0 : (e == 1) ? chunk_quads_g : k;
+			int j = (e == 2) ? 0 : (e == 3) ? chunk_quads_g : k;
+			float x = origin_x + i * spacing, z = origin_z + j * spacing;
+			write(grid_count + e * chunk_verts_g + k, x, getHeight(x, z) - skirt_depth_g, z, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+
+	// Reuse a buffer from an evicted chunk if there is one, they all have the same size
+	if (!mFreeBuffers.empty()) {
+		chunk.vbo = mFreeBuffers.back();
+		mFreeBuffers.pop_back();
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertex.size() * sizeof(GLfloat), vertex.data());
+	}
+	else {
+		glGenBuffers(1, &chunk.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertex.size() * sizeof(GLfloat), vertex.data(), GL_STATIC_DRAW);
+	}
+}
+
+
+void Terrain::update(double deltaTime)
+{
+	glm::vec3 eye = mCamera->getPosition();
+	int centre_x = (int)std::floor(eye.x / chunk_size_g);
+	int centre_z = (int)std::floor(eye.z / chunk_size_g);
+
+	// Drop chunks that fell out of range, one chunk past the load range so they don't flicker at the border
+	for (auto it = mChunks.begin(); it != mChunks.end(); ) {
+		const Chunk &chunk = it->second;
+		if (std::abs(chunk.x - centre_x) > view_chunks_g + 1 || std::abs(chunk.z - centre_z) > view_chunks_g + 1) {
+			mFreeBuffers.push_back(chunk.vbo);
+			it = mChunks.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	// Build the missing chunks closest to the camera first
+	std::vector<std::pair<int, int64_t>> missing;
+	for (int x = centre_x - view_chunks_g; x <= centre_x + view_chunks_g; x++) {
+		for (int z = centre_z - view_chunks_g; z <= centre_z + view_chunks_g; z++) {
+			if (mChunks.find(key(x, z)) == mChunks.end()) {
+				int distance = (x - centre_x) * (x - centre_x) + (z - centre_z) * (z - centre_z);
+				missing.push_back(std::make_pair(distance, key(x, z)));
+			}
+		}
+	}
+
+	int builds = std::min((int)missing.size(), chunk_builds_per_update_g);
+	std::partial_sort(missing.begin(), missing.begin() + builds, missing.end());
+	for (int i = 0; i < builds; i++) {
+		Chunk chunk;
+		chunk.x = (int)(missing[i].second >> 32);
+		chunk.z = (int)(int32_t)(missing[i].second & 0xFFFFFFFF);
+		chunk.vbo = 0;
+		buildChunk(chunk);
+		mChunks[missing[i].second] = chunk;
+	}
+}
+
+int Terrain::selectLod(const Chunk &chunk, glm::vec3 eye) const
+{
+	glm::vec3 centre((chunk.x + 0.5f) * chunk_size_g, 0.0f, (chunk.z + 0.5f) * chunk_size_g);
+	float distance = glm::distance(centre, eye);
+
+	int lod = 0;
+	for (float d = lod_distance_g; distance > d && lod < chunk_lods_g - 1; d *= 2.0f) {
+		lod++;
+	}
+	return lod;
+}
+
+void Terrain::draw(SceneNode *camera, glm::mat4 parentTransf)
+{
+	glUseProgram(mMaterial);
+
+	// Everything but the vertex buffer and the world matrix is the same for every chunk
+	if (mTexture) {
+		GLint tex = glGetUniformLocation(mMaterial, "texture_map");
+		glUniform1i(tex, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, mTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+	GLint useEnv = glGetUniformLocation(mMaterial, "useEnvMap");
+	glUniform1i(useEnv, false);
+
+
+	GLint vertex_att = glGetAttribLocation(mMaterial, "vertex");
+	GLint normal_att = glGetAttribLocation(mMaterial, "normal");
+	GLint color_att = glGetAttribLocation(mMaterial, "color");
+	GLint tex_att = glGetAttribLocation(mMaterial, "uv");
+
+	glm::vec3 eye = camera->getPosition();
+	for (auto &entry : mChunks)
+	{
+		const Chunk &chunk = entry.second;
+		int lod = selectLod(chunk, eye);
+
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mLodBuffers[lod]);
+
+		glVertexAttribPointer(vertex_att, 3, GL_FLOAT, GL_FALSE, vertex_att_g * sizeof(GLfloat), 0);
+		glEnableVertexAttribArray(vertex_att);
+		glVertexAttribPointer(normal_att, 3, GL_FLOAT, GL_FALSE, vertex_att_g * sizeof(GLfloat), (void *)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(normal_att);
+		glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, vertex_att_g * sizeof(GLfloat), (void *)(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(color_att);
+		glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, vertex_att_g * sizeof(GLfloat), (void *)(9 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(tex_att);
+
+		glm::mat4 world = glm::translate(parentTransf, glm::vec3(chunk.x * chunk_size_g, 0.0f, chunk.z * chunk_size_g));
+		// Chunks only translate, so the normal matrix is the identity
+		UniformBuffers::SetObject(world, glm::mat4(1.0));
+
+		glDrawElements(GL_TRIANGLES, mLodSizes[lod], GL_UNSIGNED_INT, 0);
+		SceneGraph::getStats().triangles += mLodSizes[lod] / 3;
+	}
+}
+
+} // namespace game
@@ -0,0 +1,63 @@
+#ifndef TERRAIN_H_
+#define TERRAIN_H_
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "scene_node.h"
+
+namespace game {
+
+	// class Terrain
+	// The ground, split into square chunks that are built around the camera as it moves and dropped behind it
+	// Heights come from a seeded noise function of the world position, so any chunk can be (re)built on its
+	// own and always matches its neighbours.
+	// Chunks use geomipmapping: every chunk has the same vertex layout, so one index buffer per level of detail
+	// is shared by all of them. Skirts hanging from the chunk edges hide the cracks between different levels.
+	class Terrain : public SceneNode {
+
+	public:
+		Terrain(const std::string name, SceneNode *camera, const Resource *material, const Resource *texture, uint32_t seed);
+		~Terrain();
+
+		// Stream chunks in and out around the camera
+		virtual void update(double deltaTime);
+		virtual void draw(SceneNode *camera, glm::mat4 parentTransf = glm::mat4(1.0));
+
+		// Ground height at a world position
+		float getHeight(float x, float z) const;
+
+		inline int getChunkCount() const { return (int)mChunks.size(); }
+
+	private:
+		struct Chunk {
+			int x, z;		// Chunk coordinates, the chunk covers [x, x + 1) * chunk size
+			GLuint vbo;
+		};
+
+		SceneNode *mCamera;
+		uint32_t mSeed;
+
+		std::unordered_map<int64_t, Chunk> mChunks;
+		std::vector<GLuint> mFreeBuffers;	// Vertex buffers of evicted chunks, reused for new ones
+
+		// Shared index buffers, one per level of detail
+		std::vector<GLuint> mLodBuffers;
+		std::vector<GLsizei> mLodSizes;
+
+		inline static int64_t key(int x, int z) { return ((int64_t)x << 32) | (uint32_t)z; }
+
+		void buildIndexBuffers(void);
+		void buildChunk(Chunk &chunk);
+		int selectLod(const Chunk &chunk, glm::vec3 eye) const;
+
+		// Smooth value noise in [0, 1]
+		float noise(float x, float z) const;
+		float lattice(int x, int z) const;
+
+	}; // class Terrain
+
+} // namespace game
+
+#endif // TERRAIN_H_
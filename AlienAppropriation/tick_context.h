@@ -0,0 +1,19 @@
+#ifndef TICK_CONTEXT_H_
+#define TICK_CONTEXT_H_
+
+#include <glm/glm.hpp>
+
+namespace game {
+
+	// struct TickContext
+	// Read-only snapshot of the world taken once per tick, before the parallel update phase
+	// Entities compute their next state from this instead of querying other nodes
+	struct TickContext {
+		glm::vec3 playerPosition;
+		double time;		// Game time at this tick, from the GameClock
+		double deltaTime;
+	};
+
+} // namespace game
+
+#endif // TICK_CONTEXT_H_
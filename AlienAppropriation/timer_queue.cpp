@@ -0,0 +1,53 @@
+#include <algorithm>
+
+#include "timer_queue.h"
+#include "entity_node.h"
+
+namespace game {
+
+std::vector<TimerQueue::Timer> TimerQueue::mHeap;
+double TimerQueue::mTime = 0.0;
+
+
+void TimerQueue::schedule(EntityNode* owner, double delay)
+{
+	Timer timer = { mTime + delay, owner->getHandle(), ++owner->mTimerGeneration };
+	mHeap.push_back(timer);
+	std::push_heap(mHeap.begin(), mHeap.end());
+}
+
+void TimerQueue::cancel(EntityNode* owner)
+{
+	// Any entry still in the heap is now stale
+	owner->mTimerGeneration++;
+}
+
+void TimerQueue::remove(EntityNode* owner)
+{
+	// Same as a cancel: a region going away releases hundreds of entities at once, and searching
+	// the heap for each of them would make that quadratic. The entries go when they reach the top
+	owner->mTimerGeneration++;
+}
+
+void TimerQueue::fire(const TickContext& ctx)
+{
+	mTime = ctx.time;
+
+	while (!mHeap.empty() && mHeap.front().time <= mTime)
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end());
+		Timer timer = mHeap.back();
+		mHeap.pop_back();
+
+		// Freed, or rescheduled, cancelled or removed since this entry was pushed
+		EntityNode* owner = static_cast<EntityNode*>(NodePool::resolve(timer.owner));
+		if (!owner || timer.generation != owner->mTimerGeneration)
+			continue;
+
+		// The callback may schedule again, the heap is consistent at this point
+		owner->wake();
+		owner->onTimer(ctx);
+	}
+}
+
+} // namespace game
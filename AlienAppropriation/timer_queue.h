@@ -0,0 +1,53 @@
+#ifndef TIMER_QUEUE_H_
+#define TIMER_QUEUE_H_
+
+#include <vector>
+
+#include "tick_context.h"
+#include "node_pool.h"
+
+namespace game {
+
+	class EntityNode;
+
+	// class TimerQueue
+	// Min-heap of entity wake-ups ordered by game time
+	// Entities that only change behaviour every few seconds register a wake-up instead of checking a timer
+	// every tick, so a tick only touches the entities whose timers actually expire.
+	// Rescheduling, cancelling and removing never search the heap: the entity's generation is bumped and
+	// the old entry is skipped when it reaches the top. Entries refer to their entity by handle, so one left
+	// behind by an entity that has since been freed is dropped the same way. Main thread only.
+	class TimerQueue {
+
+	public:
+		// Wake 'owner' 'delay' seconds of game time after the current tick, replacing its pending wake-up
+		static void schedule(EntityNode* owner, double delay);
+		// Drop the pending wake-up of 'owner', if any
+		static void cancel(EntityNode* owner);
+		// Drop every entry of 'owner', for entities leaving the scene
+		static void remove(EntityNode* owner);
+
+		// Advance to the tick time and call onTimer on every entity whose wake-up is due
+		static void fire(const TickContext& ctx);
+
+		inline static double getTime() { return mTime; }
+		inline static int getCount() { return (int)mHeap.size(); }
+
+	private:
+		struct Timer {
+			double time;
+			NodeHandle owner;
+			unsigned int generation;
+
+			// Inverted, so the std heap functions keep the earliest timer on top
+			inline bool operator<(const Timer& other) const { return time > other.time; }
+		};
+
+		static std::vector<Timer> mHeap;
+		static double mTime;	// Game time of the current tick
+
+	}; // class TimerQueue
+
+} // namespace game
+
+#endif // TIMER_QUEUE_H_
@@ -0,0 +1,97 @@
+#include "uniform_buffers.h"
+
+namespace game {
+
+// std140 packs the block exactly like the struct, the shaders and the struct have to change together
+static_assert(sizeof(FrameUniforms) == 224, "FrameUniforms must match the FrameData block");
+static_assert(sizeof(ObjectUniforms) == 128, "ObjectUniforms must match the ObjectData block");
+
+// Object slots in the ring, more than a frame's worth of draws so a slot isn't rewritten while the GPU may still read it
+const int object_ring_slots_g = 4096;
+
+GLuint UniformBuffers::mFrameBuffer = 0;
+GLuint UniformBuffers::mObjectBuffer = 0;
+GLintptr UniformBuffers::mSlotSize = sizeof(ObjectUniforms);
+int UniformBuffers::mNextSlot = 0;
+
+
+void UniformBuffers::Init()
+{
+	// Ranges bound to a block have to start on a multiple of the alignment
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment < 1)
+		alignment = 1;
+	mSlotSize = (sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &mFrameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &mObjectBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mObjectBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, mSlotSize * object_ring_slots_g, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	mNextSlot = 0;
+}
+
+void UniformBuffers::Destroy()
+{
+	glDeleteBuffers(1, &mFrameBuffer);
+	glDeleteBuffers(1, &mObjectBuffer);
+	mFrameBuffer = mObjectBuffer = 0;
+}
+
+
+void UniformBuffers::BindProgram(GLuint program)
+{
+	// Not every program reads both blocks, the particle update reads neither
+	GLuint frame = glGetUniformBlockIndex(program, "FrameData");
+	if (frame != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, frame, frame_block_binding_g);
+	}
+
+	GLuint object = glGetUniformBlockIndex(program, "ObjectData");
+	if (object != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, object, object_block_binding_g);
+	}
+}
+
+
+void UniformBuffers::SetFrame(const FrameUniforms& frame)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+	glBindBufferBase(GL_UNIFORM_BUFFER, frame_block_binding_g, mFrameBuffer);
+
+	// Nothing else binds uniform buffers: leave the ring on the generic binding point for SetObject,
+	// which keeps it there through glBindBufferRange
+	glBindBuffer(GL_UNIFORM_BUFFER, mObjectBuffer);
+}
+
+void UniformBuffers::SetObject(const glm::mat4& world, const glm::mat4& normal)
+{
+	// Once the ring is used up the storage is orphaned: the driver hands over fresh memory
+	// instead of waiting for draws still reading the old slots
+	if (mNextSlot == object_ring_slots_g) {
+		glBufferData(GL_UNIFORM_BUFFER, mSlotSize * object_ring_slots_g, NULL, GL_STREAM_DRAW);
+		mNextSlot = 0;
+	}
+
+	// Every slot is written once per ring, so no draw can still be reading it: map it without
+	// waiting for the GPU, which glBufferSubData on a buffer in use may do
+	GLintptr offset = mNextSlot * mSlotSize;
+	ObjectUniforms* object = static_cast<ObjectUniforms*>(glMapBufferRange(GL_UNIFORM_BUFFER, offset, sizeof(ObjectUniforms),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if (object) {
+		object->world = world;
+		object->normal = normal;
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+	}
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, object_block_binding_g, mObjectBuffer, offset, sizeof(ObjectUniforms));
+	mNextSlot++;
+}
+
+} // namespace game
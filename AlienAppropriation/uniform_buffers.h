@@ -0,0 +1,68 @@
+#ifndef UNIFORM_BUFFERS_H_
+#define UNIFORM_BUFFERS_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace game {
+
+	// Binding points of the shared uniform blocks, the same in every program
+	const GLuint frame_block_binding_g = 0;
+	const GLuint object_block_binding_g = 1;
+
+	// struct FrameUniforms
+	// The FrameData block of the shaders, member for member in std140 layout
+	struct FrameUniforms {
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 cameraPosition;	// xyz
+		glm::vec4 lightDirection;	// xyz, the one directional light
+		glm::vec4 lightAmbient;
+		glm::vec4 lightDiffuse;
+		glm::vec4 lightSpecular;
+		float time;
+		float pixelsPerUnit;		// Height in pixels of one unit at distance one
+		float ambientAmount;
+		float padding;
+	};
+
+	// struct ObjectUniforms
+	// The ObjectData block of the shaders
+	struct ObjectUniforms {
+		glm::mat4 world;
+		glm::mat4 normal;
+	};
+
+	// class UniformBuffers
+	// Uniform buffer objects behind the FrameData and ObjectData blocks every material declares.
+	// FrameData holds what all programs share (camera, time, lights) and goes up once per frame.
+	// ObjectData is a ring of slots: each draw writes its matrices to the next slot and binds that range,
+	// so nodes no longer look up and set their uniforms one by one in every program they use.
+	// Slots are written through unsynchronized maps, the ring is orphaned before any slot is reused.
+	// Needs a GL context, main thread only.
+	class UniformBuffers {
+
+	public:
+		static void Init();
+		static void Destroy();
+
+		// Point a program's blocks at the shared binding points, once after it is linked
+		static void BindProgram(GLuint program);
+
+		// Upload the frame data, before anything is drawn, and make the object ring current for SetObject
+		static void SetFrame(const FrameUniforms& frame);
+		// Matrices for the next draw
+		static void SetObject(const glm::mat4& world, const glm::mat4& normal);
+
+	private:
+		static GLuint mFrameBuffer;
+		static GLuint mObjectBuffer;
+		static GLintptr mSlotSize;		// ObjectUniforms rounded up to the driver's offset alignment
+		static int mNextSlot;
+
+	}; // class UniformBuffers
+
+} // namespace game
+
+#endif // UNIFORM_BUFFERS_H_